@@ -15,76 +15,82 @@ namespace Search
 	template <typename Node>
 	Path Astar(const Node &start, const Node &goal, HeuristicFunc<Node> h)
 	{
-		//Associate nodes with their depth
-		using ANode = std::pair<Node, size_t>;
+		return Astar(start, goal, FixedGoalHeuristic<Node>{ h, goal });
+	}
 
-		//Priority queue of nodes to be expanded
-		std::priority_queue<ANode, std::vector<ANode>, std::function<bool(const ANode&, const ANode&)>> open
-		(
-			[&](const ANode &a, const ANode &b) { return h(a.first, goal) + a.second > h(b.first, goal) + b.second; }
-		);
-		open.push({ start, 0 });
+	template <typename Node, typename Heuristic, typename Store>
+	Path Astar(const Node &start, const Node &goal, const Heuristic &h)
+	{
+		using Index = typename Store::Index;
 
-		//Set of nodes already visited
-		std::unordered_set<Node> closed;
+		//Stored node reached along an edge, at some depth
+		struct ANode
+		{
+			Index node, parent;
+			Operation op;
+			uint32_t depth;
+		};
 
-		//Map of node to its parent edge
-		std::unordered_map<Node, Edge<Node>> trace;
+		//Every node generated so far, each linked to its parent once expanded
+		Store store;
 
-		//Pointer to solution node, once found
-		const Node *solution = nullptr;
+		//Set of nodes already expanded, by index
+		std::vector<bool> closed;
 
-		//Only start searching if the goal isn't already reached
-		bool found = false;
-		if (start == goal)
-		{
-			solution = &goal;
-			found = true;
-		}
+		//Queue of nodes to be expanded, keyed by (whole) cost and
+		//preferring deeper nodes, so each heuristic is taken once
+		BucketQueue<ANode> open;
+		open.push({ store.insert(start).first, Store::NONE, 0, 0 }, wholeCost(h(start)), 0);
+
+		//Children of the node being expanded, whose heuristics are evaluated as a batch
+		HeuristicBatch<Node, Heuristic> batch{ h };
+		std::vector<Node> children;
+		std::vector<ANode> reached;
+		std::vector<typename HeuristicBatch<Node, Heuristic>::Value> values;
 
-		while (!found && !open.empty())
+		while (!open.empty())
 		{
-			//DEBUG - Print open queue
-			DEBUG( printCollection(open); )
+			//DEBUG - Print open queue size
+			DEBUG( std::cout << open.size() << " open" << std::endl; )
+
+			//Get the next node to expand, skipping those already reached more cheaply
+			ANode n = open.top();
+			open.pop();
+			if (n.node < closed.size() && closed[n.node])
+				continue;
+
+			//Close it along the edge it was reached by
+			closed.resize(store.size());
+			closed[n.node] = true;
+			if (n.parent != Store::NONE)
+				store.link(n.node, n.parent, n.op);
 
 			//Check for solution
-			if (open.top().first == goal)
-			{
-				solution = &open.top().first;
-				found = true;
-			}
-			else
-			{
-				//Get the next node to expand
-				ANode n = open.top();
-				open.pop();
-				closed.insert(n.first);
+			Node x = store[n.node];
+			if (x == goal)
+				return store.path(n.node);
 
-				//Get the node's children
-				for (const Edge<Node> &c : n.first.expand())
+			//Get the node's children, only keeping those not yet expanded
+			children.clear();
+			reached.clear();
+			x.expand([&](const Node &c, Operation op)
+			{
+				Index i = store.insert(c).first;
+				if (i >= closed.size() || !closed[i])
 				{
-					//Only keep new children
-					if (closed.find(c.first) == closed.end() && !found)
-					{
-						open.push({ c.first, n.second + 1 });
-
-						//Log the parent edge
-						trace.insert({ c.first, { n.first, c.second } });
-					}
+					children.push_back(c);
+					reached.push_back({ i, n.node, op, n.depth + 1 });
 				}
-			}
-		}
+			});
 
-		//Construct solution path
-		Path path;
-		while (trace.find(*solution) != trace.end())
-		{
-			path.push_back(trace.at(*solution).second);
-			solution = &trace.at(*solution).first;
+			values.resize(children.size());
+			batch.evaluate(children.data(), children.size(), values.data());
+
+			for (size_t i = 0; i < reached.size(); i++)
+				open.push(reached[i], n.depth + 1 + wholeCost(values[i]), n.depth + 1);
 		}
 
-		std::reverse(path.begin(), path.end());
-		return path;
+		return Path();
 	}
 }
 
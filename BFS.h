@@ -12,71 +12,64 @@
 
 namespace Search
 {
-	template <typename Node>
+	template <typename Node, typename Store>
 	Path BFS(const Node &start, const Node &goal)
 	{
-		//Queue of nodes to be expanded
-		std::deque<Node> open;
-		open.push_back(start);
+		using Index = typename Store::Index;
 
-		//Set of nodes already visited
-		std::unordered_set<Node> closed;
+		//Every node generated so far, with its parent edge
+		Store store;
 
-		//Map of node to its parent edge
-		std::unordered_map<Node, Edge<Node>> trace;
+		//Queue of nodes to be expanded
+		std::deque<Index> open;
+		open.push_back(store.insert(start).first);
 
-		//Pointer to solution node, once found
-		const Node *solution = nullptr;
+		//Index of solution node, once found
+		Index solution = Store::NONE;
 
 		//Only start searching if the goal isn't already reached
 		bool found = false;
 		if (start == goal)
 		{
-			solution = &goal;
+			solution = open.front();
 			found = true;
 		}
 
 		while (!found && !open.empty())
 		{
-			//DEBUG - Print open queue
-			DEBUG( printCollection(open); )
+			//DEBUG - Print open queue size
+			DEBUG( std::cout << open.size() << " open" << std::endl; )
 
 			//Get the next node to expand
-			Node n = open.front();
+			Index i = open.front();
 			open.pop_front();
-			closed.insert(n);
+			Node n = store[i];
 
 			//Get the node's children
-			for (const Edge<Node> &c : n.expand())
+			n.expand([&](const Node &c, Operation op)
 			{
-				//Only keep new children
-				if (closed.find(c.first) == closed.end() && !found)
-				{
-					open.push_back(c.first);
+				if (found)
+					return;
 
-					//Log the parent edge
-					trace.insert({ open.back(), { n, c.second } });
+				//Only keep new children, logging the parent edge
+				std::pair<Index, bool> inserted = store.insert(c);
+				if (inserted.second)
+				{
+					store.link(inserted.first, i, op);
+					open.push_back(inserted.first);
 
 					//Check for solution
-					if (open.back() == goal)
+					if (c == goal)
 					{
-						solution = &open.back();
+						solution = inserted.first;
 						found = true;
 					}
 				}
-			}
+			});
 		}
 
 		//Construct solution path
-		Path path;
-		while (trace.find(*solution) != trace.end())
-		{
-			path.push_back(trace.at(*solution).second);
-			solution = &trace.at(*solution).first;
-		}
-
-		std::reverse(path.begin(), path.end());
-		return path;
+		return found ? store.path(solution) : Path();
 	}
 }
 
@@ -0,0 +1,592 @@
+/**
+ * Benchmark.cpp
+ * Implements microbenchmarks of routines on the heuristic
+ * path.
+ *
+ * @author Sam Griffiths
+ */
+
+#include "Benchmark.h"
+#include "Utility.h"
+#include "Ranking.h"
+
+#include <chrono>
+#include <numeric>
+#include <sstream>
+#include <unordered_map>
+
+namespace
+{
+	using clock = std::chrono::high_resolution_clock;
+
+	//Random Cubes to benchmark over, few enough to stay in cache
+	const size_t SAMPLES = 4096;
+
+	//Passes over the samples per timing
+	const size_t PASSES = 500;
+
+	/* The enumeration routines formerly used: each cubie was turned into
+		a string of face letters, searched for among the goal cubies, and
+		compared against rotations of its goal cubie for orientation. */
+
+	CornerConfig referenceCornerConfig(const Cube &cube)
+	{
+		static std::vector<std::string> pieces { GOAL_CUBE.cubie(12).string(),
+			GOAL_CUBE.cubie(13).string(), GOAL_CUBE.cubie(14).string(),
+			GOAL_CUBE.cubie(15).string(), GOAL_CUBE.cubie(16).string(),
+			GOAL_CUBE.cubie(17).string(), GOAL_CUBE.cubie(18).string(),
+			GOAL_CUBE.cubie(19).string() };
+
+		auto lookupEnum = [](const std::string &s) -> uint8_t {
+			for (uint8_t i = 0; i < pieces.size(); i++)
+				if (std::is_permutation(s.begin(), s.end(), pieces[i].begin()))
+					return i;
+			return 0;
+		};
+
+		CornerConfig result = {};
+
+		for (size_t i = 0; i < 8; i++)
+		{
+			std::string cubie = cube.cubie(12 + i).string();
+			result[i] = lookupEnum(cubie);
+
+			if (i < 7)
+			{
+				const std::string &goalCubie = pieces[result[i]];
+				if (cubie != goalCubie)
+				{
+					std::string nextOrientation = goalCubie.substr(1, 2) + goalCubie[0];
+					result[i + 8] = (cubie == nextOrientation) ? 1 : 2;
+				}
+			}
+		}
+
+		return result;
+	}
+
+	EdgeConfig referenceEdgeConfig(const Cube &cube, int set)
+	{
+		static std::vector<std::string> pieces { GOAL_CUBE.cubie(0).string(),
+			GOAL_CUBE.cubie(1).string(), GOAL_CUBE.cubie(2).string(),
+			GOAL_CUBE.cubie(3).string(), GOAL_CUBE.cubie(4).string(),
+			GOAL_CUBE.cubie(5).string(), GOAL_CUBE.cubie(6).string(),
+			GOAL_CUBE.cubie(7).string(), GOAL_CUBE.cubie(8).string(),
+			GOAL_CUBE.cubie(9).string(), GOAL_CUBE.cubie(10).string(),
+			GOAL_CUBE.cubie(11).string() };
+
+		auto lookupEnum = [](const std::string &s) -> uint8_t {
+			for (uint8_t i = 0; i < pieces.size(); i++)
+				if (std::is_permutation(s.begin(), s.end(), pieces[i].begin()))
+					return i;
+			return 0;
+		};
+
+		EdgeConfig result = { 6, {} };
+		Cube c = (set == 1) ? cube : edgeSetSymmetry().conjugate(cube);
+
+		for (size_t i = 0; i < 6; i++)
+		{
+			std::string cubie = c.cubie(EDGE_SET[i]).string();
+			result.values[i] = lookupEnum(cubie);
+
+			if (cubie != pieces[result[i]])
+				result.values[i + 6] = 1;
+		}
+
+		return result;
+	}
+
+	/* The ranking routines formerly used: Lehmer digits counted over a
+		bool array, and orientations parsed from a string of digits. */
+
+	size_t referenceCornerIndex(const CornerConfig &config)
+	{
+		size_t index = 0;
+		size_t n = 88179840;
+		size_t p = 8;
+
+		bool indices[8];
+		for (size_t i = 0; i < 8; i++)
+			indices[i] = true;
+
+		while (p > 1)
+		{
+			size_t c = 0;
+			for (size_t i = 0; i < config[8 - p]; i++)
+				if (indices[i])
+					c++;
+
+			indices[config[8 - p]] = false;
+			n /= p;
+			p--;
+			index += c * n;
+		}
+
+		std::string base3;
+		for (size_t i = 8; i < 15; i++)
+			base3 += config[i] + '0';
+
+		return index + std::stoi(base3, nullptr, 3);
+	}
+
+	size_t referenceEdgeIndex(const EdgeConfig &config)
+	{
+		size_t index = 0;
+		size_t n = 42577920;
+		size_t p = 6;
+		size_t q = 12;
+
+		bool indices[12];
+		for (size_t i = 0; i < 12; i++)
+			indices[i] = true;
+
+		while (p > 0)
+		{
+			size_t c = 0;
+			for (size_t i = 0; i < config[6 - p]; i++)
+				if (indices[i])
+					c++;
+
+			indices[config[6 - p]] = false;
+			n /= q;
+			p--; q--;
+			index += c * n;
+		}
+
+		std::string base2;
+		for (size_t i = 6; i < 12; i++)
+			base2 += config[i] + '0';
+
+		return index + std::stoi(base2, nullptr, 2);
+	}
+
+	void referenceUnrankPositions(size_t index, uint8_t *p, size_t k, size_t n)
+	{
+		bool used[12] = { false };
+
+		for (size_t i = 0; i < k; i++)
+		{
+			size_t w = 1;
+			for (size_t j = 0; j < k - 1 - i; j++)
+				w *= n - 1 - i - j;
+
+			size_t c = index / w;
+			index %= w;
+
+			uint8_t j = 0;
+			while (used[j] || c-- > 0)
+				j++;
+
+			p[i] = j;
+			used[j] = true;
+		}
+	}
+
+	/* The Manhattan lookup formerly used: distances held in nested maps
+		keyed by face letters, with two string lookups per edge. */
+
+	using ManhattanMap = std::unordered_map<std::string, std::unordered_map<std::string, size_t>>;
+
+	ManhattanMap referenceManhattanMap(std::istream &is)
+	{
+		ManhattanMap m;
+		std::string sa, sb, val;
+
+		while (std::getline(is, sa, ','))
+		{
+			std::getline(is, sb, ',');
+			std::getline(is, val);
+			m[sa][sb] = std::stoi(val);
+		}
+
+		return m;
+	}
+
+	size_t referenceManhattanLookup(const Cube::Cubie &a, const Cube::Cubie &b, const ManhattanMap &m)
+	{
+		std::string ca(a.string()), cb(b.string());
+
+		if (ca == cb) return 0;
+
+		if (m.find(ca) == m.end())
+		{
+			std::reverse(ca.begin(), ca.end());
+			std::reverse(cb.begin(), cb.end());
+		}
+
+		auto it = m.find(ca);
+		if (it == m.end())
+			return 0;
+
+		auto jt = it->second.find(cb);
+		return (jt == it->second.end()) ? 0 : jt->second;
+	}
+
+	size_t referenceManhattanSum(const Cube &cube, const ManhattanMap &m)
+	{
+		size_t sum = 0;
+		for (size_t i = 0; i < Cube::NUMBER_OF_EDGES; i++)
+			sum += referenceManhattanLookup(cube.cubie(i), GOAL_CUBE.cubie(i), m);
+		return sum;
+	}
+
+	//Returns the mean time in nanoseconds of f over all samples, adding its results to sink
+	template <typename F>
+	double timePerSample(size_t samples, size_t &sink, F f, size_t passes = PASSES)
+	{
+		clock::time_point t0 = clock::now();
+		for (size_t pass = 0; pass < passes; pass++)
+			for (size_t i = 0; i < samples; i++)
+				sink += f(i);
+		clock::time_point t1 = clock::now();
+
+		return std::chrono::duration<double, std::nano>(t1 - t0).count() / (passes * samples);
+	}
+
+	//Pattern database of n arbitrary values, standing in for a generated one (its pages
+	//must differ, as some hosts back identical pages, e.g. zeroed ones, with one copy)
+	PatternDatabase randomPatternDatabase(size_t n, uint64_t seed)
+	{
+		std::vector<FourBitIntPair> entries(n / 2);
+		for (size_t i = 0; i < entries.size(); i++)
+			entries[i] = FourBitIntPair(uint8_t(Cube::mix(seed + i)));
+
+		return PatternDatabase(std::move(entries));
+	}
+
+	void report(std::ostream &os, const char *name, double reference, double current)
+	{
+		os << name << ": " << reference << " ns before, " << current << " ns now ("
+			<< reference / current << "x)" << std::endl;
+	}
+}
+
+void benchmarkRanking(std::ostream &os)
+{
+	std::vector<CornerConfig> corners;
+	std::vector<EdgeConfig> edges;
+	std::vector<size_t> cornerIndices, edgeIndices;
+
+	for (size_t i = 0; i < SAMPLES; i++)
+	{
+		Cube c = generateCubeProblem(20);
+		corners.push_back(enumerateCornerConfig(c));
+		edges.push_back(enumerateEdgeConfig(c, 1 + int(i % 2)));
+		cornerIndices.push_back(getCornerConfigIndex(corners.back()));
+		edgeIndices.push_back(getEdgeConfigIndex(edges.back()));
+
+		//Both must agree before either is worth timing
+		uint8_t p[12], q[12];
+		unrankPositions(edgeIndices.back() / 64, p, 6, 12);
+		referenceUnrankPositions(edgeIndices.back() / 64, q, 6, 12);
+
+		if (cornerIndices.back() != referenceCornerIndex(corners.back()) ||
+			edgeIndices.back() != referenceEdgeIndex(edges.back()) || !std::equal(p, p + 6, q))
+		{
+			os << "Error: Ranking disagrees with reference" << std::endl;
+			return;
+		}
+
+		//Node stores keep Cubes by rank, so each must unrank to the Cube ranked
+		Cube::Rank r = c.rank();
+		if (!(Cube::unrank(r) == c) || r.corners != cornerIndices.back())
+		{
+			os << "Error: Cube rank does not round-trip" << std::endl;
+			return;
+		}
+	}
+
+	size_t sink = 0;
+	uint8_t p[12];
+
+	report(os, "Corner index", timePerSample(SAMPLES, sink, [&](size_t i) { return referenceCornerIndex(corners[i]); }),
+		timePerSample(SAMPLES, sink, [&](size_t i) { return getCornerConfigIndex(corners[i]); }));
+
+	report(os, "Edge index", timePerSample(SAMPLES, sink, [&](size_t i) { return referenceEdgeIndex(edges[i]); }),
+		timePerSample(SAMPLES, sink, [&](size_t i) { return getEdgeConfigIndex(edges[i]); }));
+
+	report(os, "Corner permutation unrank",
+		timePerSample(SAMPLES, sink, [&](size_t i) { referenceUnrankPositions(cornerIndices[i] / 2187, p, 8, 8); return p[3]; }),
+		timePerSample(SAMPLES, sink, [&](size_t i) { unrankPositions(cornerIndices[i] / 2187, p, 8, 8); return p[3]; }));
+
+	report(os, "Edge permutation unrank",
+		timePerSample(SAMPLES, sink, [&](size_t i) { referenceUnrankPositions(edgeIndices[i] / 64, p, 6, 12); return p[3]; }),
+		timePerSample(SAMPLES, sink, [&](size_t i) { unrankPositions(edgeIndices[i] / 64, p, 6, 12); return p[3]; }));
+
+	//Keep the results live
+	if (sink == 0)
+		os << std::endl;
+}
+
+void benchmarkEnumeration(std::ostream &os)
+{
+	std::vector<Cube> cubes;
+
+	for (size_t i = 0; i < SAMPLES; i++)
+	{
+		cubes.push_back(generateCubeProblem(20));
+
+		//Both must agree before either is worth timing
+		const Cube &c = cubes.back();
+		EdgeConfig a = enumerateEdgeConfig(c, 1 + int(i % 2)), b = referenceEdgeConfig(c, 1 + int(i % 2));
+		if (enumerateCornerConfig(c) != referenceCornerConfig(c) ||
+			!std::equal(a.values.begin(), a.values.begin() + 12, b.values.begin()))
+		{
+			os << "Error: Enumeration disagrees with reference" << std::endl;
+			return;
+		}
+	}
+
+	size_t sink = 0;
+
+	report(os, "Corner enumeration", timePerSample(SAMPLES, sink, [&](size_t i) { return referenceCornerConfig(cubes[i])[5]; }),
+		timePerSample(SAMPLES, sink, [&](size_t i) { return enumerateCornerConfig(cubes[i])[5]; }));
+
+	report(os, "Edge enumeration", timePerSample(SAMPLES, sink, [&](size_t i) { return referenceEdgeConfig(cubes[i], 1)[5]; }),
+		timePerSample(SAMPLES, sink, [&](size_t i) { return enumerateEdgeConfig(cubes[i], 1)[5]; }));
+
+	//Keep the results live
+	if (sink == 0)
+		os << std::endl;
+}
+
+void benchmarkManhattan(std::ostream &os)
+{
+	std::stringstream csv;
+	generateManhattanTable(csv);
+	ManhattanMap m = referenceManhattanMap(csv);
+	ManhattanTable table;
+	std::vector<Cube> cubes;
+
+	for (size_t i = 0; i < SAMPLES; i++)
+	{
+		cubes.push_back(generateCubeProblem(20));
+
+		//Both must agree before either is worth timing
+		if (table.sum(cubes.back()).edges != referenceManhattanSum(cubes.back(), m))
+		{
+			os << "Error: Manhattan table disagrees with reference" << std::endl;
+			return;
+		}
+	}
+
+	size_t sink = 0;
+
+	os << "Sum kernel: " << ManhattanTable::sumKernelName() << std::endl;
+
+	report(os, "Manhattan sum", timePerSample(SAMPLES, sink, [&](size_t i) { return referenceManhattanSum(cubes[i], m); }),
+		timePerSample(SAMPLES, sink, [&](size_t i) { ManhattanTable::Sums s = table.sum(cubes[i]); return s.edges + s.corners; }));
+
+	//Keep the results live
+	if (sink == 0)
+		os << std::endl;
+}
+
+void benchmarkPrefetch(std::ostream &os)
+{
+	//Tables the size of the default databases, far too large to stay in cache
+	PatternDatabase corner = randomPatternDatabase(88179840, 1);
+	PatternDatabase edge = randomPatternDatabase(42577920, 2);
+	PatternDatabaseHeuristic h{ corner, edge };
+	Search::HeuristicBatch<CubeNode, PatternDatabaseHeuristic> batch{ h };
+
+	//The children of each sample, as a search expands them
+	std::vector<CubeNode> children;
+	for (size_t i = 0; i < SAMPLES; i++)
+	{
+		CubeNode n(generateCubeProblem(20));
+		n.expand([&](const CubeNode &c, Search::Operation) { children.push_back(c); });
+	}
+
+	//Both must agree before either is worth timing
+	std::vector<uint8_t> values(children.size());
+	batch.evaluate(children.data(), children.size(), values.data());
+	for (size_t i = 0; i < children.size(); i++)
+		if (values[i] != h(children[i]))
+		{
+			os << "Error: Batched evaluation disagrees with reference" << std::endl;
+			return;
+		}
+
+	size_t sink = 0, passes = 20;
+	const size_t n = CubeNode::OPERATIONS;
+
+	//Index computation alone, leaving only memory stalls to tell the others apart
+	double indices = timePerSample(SAMPLES, sink, [&](size_t i) {
+		size_t x = 0;
+		for (size_t j = i * n; j < (i + 1) * n; j++)
+			x += getCornerConfigIndex(enumerateCornerConfig(children[j].cube)) + getEdgeConfigIndex(enumerateEdgeConfig(children[j].cube, 1)) +
+				getEdgeConfigIndex(enumerateEdgeConfig(children[j].cube, 2));
+		return x;
+	}, passes) / n;
+
+	double single = timePerSample(SAMPLES, sink, [&](size_t i) {
+		size_t x = 0;
+		for (size_t j = i * n; j < (i + 1) * n; j++)
+			x += h(children[j]);
+		return x;
+	}, passes) / n;
+
+	double batched = timePerSample(SAMPLES, sink, [&](size_t i) {
+		uint8_t v[n];
+		batch.evaluate(&children[i * n], n, v);
+		return std::accumulate(v, v + n, size_t(0));
+	}, passes) / n;
+
+	os << "Index computation: " << indices << " ns per child" << std::endl;
+	report(os, "Heuristic per child", single, batched);
+	report(os, "Memory stall per child", single - indices, batched - indices);
+
+	//Keep the results live
+	if (sink == 0)
+		os << std::endl;
+}
+
+void benchmarkSymmetryReduction(std::ostream &os)
+{
+	SymmetryReduction cornerReduction, edgeReduction(EDGE_SET);
+
+	os << "Corner database: " << Cube::CORNER_RANKS << " entries before, " << cornerReduction.size() << " now ("
+		<< double(Cube::CORNER_RANKS) / cornerReduction.size() << "x smaller, " << cornerReduction.symmetries()
+		<< " symmetries)" << std::endl;
+	os << "Edge database: " << edgePatternDatabaseSize(EDGE_SET.size()) << " entries before, " << edgeReduction.size()
+		<< " now (" << double(edgePatternDatabaseSize(EDGE_SET.size())) / edgeReduction.size() << "x smaller, "
+		<< edgeReduction.symmetries() << " symmetries)" << std::endl;
+
+	//Tables of each size, the reduced ones read through their classes
+	PatternDatabase corner = randomPatternDatabase(Cube::CORNER_RANKS, 1);
+	PatternDatabase edge = randomPatternDatabase(edgePatternDatabaseSize(EDGE_SET.size()), 2);
+	PatternDatabase reducedCorner = randomPatternDatabase(cornerReduction.size(), 3);
+	PatternDatabase reducedEdge = randomPatternDatabase(edgeReduction.size(), 4);
+
+	std::vector<ReducedPatternDatabase> databases { { cornerReduction, reducedCorner, nullptr },
+		{ edgeReduction, reducedEdge, nullptr }, { edgeReduction, reducedEdge, &edgeSetSymmetry() } };
+	PatternDatabaseHeuristic h{ corner, edge };
+	ReducedPatternDatabasesHeuristic reduced{ databases };
+	Search::HeuristicBatch<CubeNode, PatternDatabaseHeuristic> batch{ h };
+	Search::HeuristicBatch<CubeNode, ReducedPatternDatabasesHeuristic> reducedBatch{ reduced };
+
+	//The children of each sample, as a search expands them
+	std::vector<CubeNode> children;
+	for (size_t i = 0; i < SAMPLES; i++)
+	{
+		CubeNode n(generateCubeProblem(20));
+		n.expand([&](const CubeNode &c, Search::Operation) { children.push_back(c); });
+	}
+
+	//Batched evaluation must agree with evaluation one node at a time
+	std::vector<uint8_t> values(children.size());
+	reducedBatch.evaluate(children.data(), children.size(), values.data());
+	for (size_t i = 0; i < children.size(); i++)
+		if (values[i] != reduced(children[i]))
+		{
+			os << "Error: Batched evaluation disagrees with reference" << std::endl;
+			return;
+		}
+
+	size_t sink = 0, passes = 20;
+	const size_t n = CubeNode::OPERATIONS;
+
+	auto perChild = [&](auto &b) {
+		return timePerSample(SAMPLES, sink, [&](size_t i) {
+			uint8_t v[n];
+			b.evaluate(&children[i * n], n, v);
+			return std::accumulate(v, v + n, size_t(0));
+		}, passes) / n;
+	};
+
+	report(os, "Heuristic per child", perChild(batch), perChild(reducedBatch));
+
+	//Keep the results live
+	if (sink == 0)
+		os << std::endl;
+}
+
+void benchmarkDualHeuristic(std::ostream &os)
+{
+	PatternDatabase corner = randomPatternDatabase(88179840, 1);
+	PatternDatabase edge = randomPatternDatabase(42577920, 2);
+	PatternDatabaseHeuristic h{ corner, edge };
+	DualHeuristic<PatternDatabaseHeuristic> dual{ h };
+	Search::HeuristicTracker<CubeNode, PatternDatabaseHeuristic> tracker{ h };
+	Search::HeuristicTracker<CubeNode, DualHeuristic<PatternDatabaseHeuristic>> dualTracker{ dual };
+
+	//Each sample's track, and its children and their moves, as a search expands them
+	std::vector<DualHeuristic<PatternDatabaseHeuristic>::Track> parents;
+	std::vector<CubeNode> children;
+	Search::Path ops;
+	for (size_t i = 0; i < SAMPLES; i++)
+	{
+		CubeNode n(generateCubeProblem(20));
+		parents.push_back(dual.track(n));
+		n.expand([&](const CubeNode &c, Search::Operation op) { children.push_back(c); ops.push_back(op); });
+
+		if (!(n.cube.apply(parents.back().inverse) == GOAL_CUBE) || !(parents.back().inverse.apply(n.cube) == GOAL_CUBE))
+		{
+			os << "Error: Inverse state disagrees with reference" << std::endl;
+			return;
+		}
+	}
+
+	const size_t n = CubeNode::OPERATIONS;
+
+	//Inverses tracked from the parent must be those found from scratch
+	std::vector<DualHeuristic<PatternDatabaseHeuristic>::Track> tracks(children.size());
+	for (size_t i = 0; i < SAMPLES; i++)
+		dualTracker.track(parents[i], &children[i * n], &ops[i * n], n, &tracks[i * n]);
+	for (size_t i = 0; i < children.size(); i++)
+		if (!(tracks[i].inverse == children[i].cube.inverse()) || tracks[i].value != dual(children[i]))
+		{
+			os << "Error: Tracked inverse disagrees with reference" << std::endl;
+			return;
+		}
+
+	size_t sink = 0, passes = 20;
+
+	auto perChild = [&](auto &t, auto parent) {
+		return timePerSample(SAMPLES, sink, [&](size_t i) {
+			decltype(parent(i)) v[n];
+			t.track(parent(i), &children[i * n], &ops[i * n], n, v);
+			return std::accumulate(v, v + n, size_t(0), [&](size_t x, const auto &track) { return x + t.cost(track); });
+		}, passes) / n;
+	};
+
+	report(os, "Tracked heuristic per child", perChild(tracker, [](size_t) { return uint8_t(0); }),
+		perChild(dualTracker, [&](size_t i) { return parents[i]; }));
+
+	//Keep the results live
+	if (sink == 0)
+		os << std::endl;
+}
+
+void benchmarkLookupLatency(std::ostream &os)
+{
+	//A table the size of a 7-edge database, beyond most last-level caches
+	PatternDatabase heap = randomPatternDatabase(edgePatternDatabaseSize(7), 1);
+
+	//Each lookup's index follows from the last value read, so that their latencies add up
+	size_t sink = 0;
+	auto chase = [&sink](const PatternDatabase &pd) {
+		size_t x = 0;
+		return timePerSample(SAMPLES, sink, [&](size_t) {
+			x = size_t(Cube::mix(x + pd[x % pd.size()].x));
+			return x & 1;
+		}, 100);
+	};
+
+	double reference = chase(heap);
+	os << "Lookup latency in " << heap.placement() << ": " << reference << " ns" << std::endl;
+
+	const bool placements[3][2] = { { false, false }, { true, false }, { true, true } };
+	for (const bool *p : placements)
+	{
+		PatternDatabase placed = heap.place(p[0], p[1]);
+		std::string name = "Lookup latency in " + placed.placement() + (p[1] ? ", replicated" : "");
+		report(os, name.c_str(), reference, chase(placed));
+	}
+
+	//Keep the results live
+	if (sink == 0)
+		os << std::endl;
+}
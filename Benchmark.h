@@ -0,0 +1,37 @@
+/**
+ * Benchmark.h
+ * Declares microbenchmarks of routines on the heuristic
+ * path, each timed against the routine it replaced on the
+ * same random inputs.
+ *
+ * @author Sam Griffiths
+ */
+
+#pragma once
+
+#include <iostream>
+
+//Times pattern database index ranking and unranking, reporting to the given stream
+void benchmarkRanking(std::ostream &os);
+
+//Times enumeration of the piece configurations of a Cube, reporting to the given stream
+void benchmarkEnumeration(std::ostream &os);
+
+//Times summation of the Manhattan distances of a Cube, reporting to the given stream
+void benchmarkManhattan(std::ostream &os);
+
+//Times pattern database heuristics over the children of a node, one at a time and
+//batched with prefetching, reporting to the given stream
+void benchmarkPrefetch(std::ostream &os);
+
+//Reports the sizes of the symmetry-reduced pattern databases, and times their heuristic
+//over the children of a node against the full databases, reporting to the given stream
+void benchmarkSymmetryReduction(std::ostream &os);
+
+//Checks inverse states tracked along a search path, and times the pattern database heuristic
+//over the children of a node with and without inverse lookups, reporting to the given stream
+void benchmarkDualHeuristic(std::ostream &os);
+
+//Times dependent pattern database lookups with the entries held in each placement
+//available, reporting to the given stream
+void benchmarkLookupLatency(std::ostream &os);
@@ -0,0 +1,82 @@
+/**
+ * BucketQueue.h
+ * Implements a priority queue over small integer keys as
+ * an array of buckets, giving constant time push and pop.
+ * Elements of equal key are ordered by a second small
+ * integer (largest first, unless the queue is told to take
+ * the smallest), then last in first out.
+ *
+ * @author Sam Griffiths
+ */
+
+#ifndef BucketQueue_H
+#define BucketQueue_H
+
+#include "Search.h"
+
+namespace Search
+{
+	template <typename T, bool LargestTie = true>
+	class BucketQueue
+	{
+	public:
+		BucketQueue() : count(0), minimum(0) {}
+
+		bool empty() const { return count == 0; }
+		size_t size() const { return count; }
+
+		//Adds an element under the given key and tie-breaker
+		void push(const T &x, size_t key, size_t tie)
+		{
+			if (key >= buckets.size())
+				buckets.resize(key + 1);
+
+			Bucket &b = buckets[key];
+			if (tie >= b.ties.size())
+				b.ties.resize(tie + 1);
+
+			b.ties[tie].push_back(x);
+			if (b.count++ == 0 || (LargestTie ? tie > b.best : tie < b.best))
+				b.best = tie;
+
+			if (count++ == 0 || key < minimum)
+				minimum = key;
+		}
+
+		//Returns the element of least key (and preferred tie-breaker)
+		const T& top() const
+		{
+			const Bucket &b = buckets[minimum];
+			return b.ties[b.best].back();
+		}
+
+		//Removes the top element
+		void pop()
+		{
+			Bucket &b = buckets[minimum];
+			b.ties[b.best].pop_back();
+			count--;
+
+			//Move on to the next non-empty list
+			if (--b.count > 0)
+				while (b.ties[b.best].empty())
+					LargestTie ? b.best-- : b.best++;
+			else if (count > 0)
+				while (buckets[minimum].count == 0)
+					minimum++;
+		}
+
+	private:
+		//Elements of one key, listed by tie-breaker
+		struct Bucket
+		{
+			std::vector<std::vector<T>> ties;
+			size_t count = 0, best = 0;
+		};
+
+		std::vector<Bucket> buckets;
+		size_t count, minimum;
+	};
+}
+
+#endif
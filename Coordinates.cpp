@@ -0,0 +1,103 @@
+/**
+ * Coordinates.cpp
+ * Implements move tables acting directly on the corner and
+ * edge pattern database indices.
+ *
+ * @author Sam Griffiths
+ */
+
+#include "Coordinates.h"
+#include "Utility.h"
+#include "Ranking.h"
+
+#include <stdexcept>
+
+CoordinateTables::CoordinateTables()
+	: cornerPermutation(CORNER_PERMUTATIONS * Cube::NUMBER_OF_MOVES),
+	cornerOrientation(CORNER_ORIENTATIONS * CORNER_ORIENTATIONS)
+{
+	uint8_t p[Cube::NUMBER_OF_CORNERS], q[Cube::NUMBER_OF_CORNERS];
+
+	//Corner permutations, noting the orientation change of the first 7 pieces
+	for (size_t r = 0; r < CORNER_PERMUTATIONS; r++)
+	{
+		unrankPositions(r, p, 8, 8);
+
+		for (size_t m = 0; m < Cube::NUMBER_OF_MOVES; m++)
+		{
+			uint32_t delta = 0;
+			for (size_t i = 0; i < 8; i++)
+			{
+				uint8_t x = Cube::MOVES[m].corners[p[i]];
+				q[i] = x & 15;
+				if (i < 7)
+					delta = delta * 3 + (x >> 4);
+			}
+
+			cornerPermutation[r * Cube::NUMBER_OF_MOVES + m] =
+				uint32_t(rankPositions(q, 8, 8)) | (delta << 16);
+		}
+	}
+
+	//Digit-wise addition of base 3 orientations
+	for (size_t a = 0; a < CORNER_ORIENTATIONS; a++)
+		for (size_t b = 0; b < CORNER_ORIENTATIONS; b++)
+		{
+			size_t sum = 0;
+			for (size_t x = a, y = b, w = 1; w < CORNER_ORIENTATIONS; x /= 3, y /= 3, w *= 3)
+				sum += (x % 3 + y % 3) % 3 * w;
+
+			cornerOrientation[a * CORNER_ORIENTATIONS + b] = uint16_t(sum);
+		}
+}
+
+EdgeMoveTable::EdgeMoveTable(size_t k)
+	: k(k)
+{
+	if (k < 1 || k > 8)
+		throw std::invalid_argument("Edge patterns must cover 1-8 pieces");
+
+	size_t permutations = arrangements(Cube::NUMBER_OF_EDGES, k);
+	permutation.resize(permutations * Cube::NUMBER_OF_MOVES);
+	flips.resize(permutations * Cube::NUMBER_OF_MOVES);
+
+	uint8_t e[8], f[8];
+
+	for (size_t r = 0; r < permutations; r++)
+	{
+		unrankPositions(r, e, k, Cube::NUMBER_OF_EDGES);
+
+		for (size_t m = 0; m < Cube::NUMBER_OF_MOVES; m++)
+		{
+			uint8_t delta = 0;
+			for (size_t i = 0; i < k; i++)
+			{
+				uint8_t x = Cube::MOVES[m].edges[e[i]];
+				f[i] = x & 15;
+				delta = uint8_t(delta * 2 + (x >> 4));
+			}
+
+			permutation[r * Cube::NUMBER_OF_MOVES + m] = uint32_t(rankPositions(f, k, Cube::NUMBER_OF_EDGES));
+			flips[r * Cube::NUMBER_OF_MOVES + m] = delta;
+		}
+	}
+}
+
+const CoordinateTables& CoordinateTables::get()
+{
+	static const CoordinateTables tables;
+	return tables;
+}
+
+const Symmetry& edgeSetSymmetry()
+{
+	static const Symmetry x2("DURLBF");
+	return x2;
+}
+
+CubeIndices::CubeIndices(const Cube &cube)
+	: corner(getCornerConfigIndex(enumerateCornerConfig(cube))),
+	edge1(getEdgeConfigIndex(enumerateEdgeConfig(cube, 1))),
+	edge2(getEdgeConfigIndex(enumerateEdgeConfig(cube, 2)))
+{
+}
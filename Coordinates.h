@@ -0,0 +1,90 @@
+/**
+ * Coordinates.h
+ * Declares move tables acting directly on the corner and
+ * edge pattern database indices, so that the databases can
+ * be generated over indices alone, without building a Cube
+ * for every state.
+ *
+ * @author Sam Griffiths
+ */
+
+#pragma once
+
+#include "Cube.h"
+#include "Symmetry.h"
+
+#include <vector>
+
+/* A corner index is (permutation rank * 3^7 + orientation), as produced
+	by getCornerConfigIndex. The permutation part is moved by table; the
+	orientation change it reports is then added digit-wise. */
+struct CoordinateTables
+{
+	//Sizes of the permutation and orientation parts of an index
+	static const size_t CORNER_PERMUTATIONS = 40320;
+	static const size_t CORNER_ORIENTATIONS = 2187;
+
+	//(Corner permutation, move) -> new permutation + 2^16 * orientation change
+	std::vector<uint32_t> cornerPermutation;
+
+	//(Corner orientation, orientation change) -> digit-wise sum mod 3
+	std::vector<uint16_t> cornerOrientation;
+
+
+	//Returns the shared tables, generating them on first use
+	static const CoordinateTables& get();
+
+	//Returns the corner index reached by applying the given move
+	size_t twistCorner(size_t index, Cube::Move m) const
+	{
+		uint32_t t = cornerPermutation[index / CORNER_ORIENTATIONS * Cube::NUMBER_OF_MOVES + m];
+		return (t & 0xFFFF) * CORNER_ORIENTATIONS +
+			cornerOrientation[index % CORNER_ORIENTATIONS * CORNER_ORIENTATIONS + (t >> 16)];
+	}
+
+private:
+	CoordinateTables();
+};
+
+/* An edge index over any k pieces (k at most 8) is likewise (partial
+	permutation rank * 2^k + flips), as produced by getEdgeConfigIndex.
+	Permutations of 8 pieces leave no room in 32 bits for the flips, so
+	those are kept in their own table. */
+class EdgeMoveTable
+{
+public:
+	//Generates the tables for patterns of k edge pieces
+	explicit EdgeMoveTable(size_t k);
+
+	//Returns the index reached by applying the given move
+	size_t twist(size_t index, Cube::Move m) const
+	{
+		size_t t = (index >> k) * Cube::NUMBER_OF_MOVES + m;
+		return size_t(permutation[t]) << k | ((index & ((size_t(1) << k) - 1)) ^ flips[t]);
+	}
+
+private:
+	size_t k;
+
+	//(Partial permutation, move) -> new permutation, and flip change
+	std::vector<uint32_t> permutation;
+	std::vector<uint8_t> flips;
+};
+
+/* The default edge pattern database covers edges 0-3, 8 and 9 (UF UR UB
+	UL FR FL). The whole-cube half turn x2 carries the other six edges onto
+	these, so the same database gives their value in the conjugated state. */
+const Symmetry& edgeSetSymmetry();
+
+//The three pattern database indices of a Cube, the second edge index
+//being that of the conjugated state
+struct CubeIndices
+{
+	size_t corner, edge1, edge2;
+
+
+	CubeIndices() : corner(0), edge1(0), edge2(0) {}
+
+	//Enumerates the indices of the given Cube
+	CubeIndices(const Cube &cube);
+};
@@ -0,0 +1,53 @@
+/**
+ * CpuFeatures.cpp
+ * Implements detection of the instruction set extensions
+ * the running CPU (and operating system) supports.
+ *
+ * @author Sam Griffiths
+ */
+
+#include "CpuFeatures.h"
+
+#if defined(CPU_X86) && defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+namespace
+{
+	CpuFeatures detectFeatures()
+	{
+		CpuFeatures features{ false, false };
+
+#ifdef CPU_X86
+	#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		features.ssse3 = (info[2] & (1 << 9)) != 0;
+
+		//AVX registers must also be saved by the operating system
+		bool osAVX = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+
+		if (maxLeaf >= 7 && osAVX)
+		{
+			__cpuidex(info, 7, 0);
+			features.avx2 = (info[1] & (1 << 5)) != 0;
+		}
+	#else
+		__builtin_cpu_init();
+		features.ssse3 = __builtin_cpu_supports("ssse3");
+		features.avx2 = __builtin_cpu_supports("avx2");
+	#endif
+#endif
+
+		return features;
+	}
+}
+
+const CpuFeatures& cpuFeatures()
+{
+	static const CpuFeatures features = detectFeatures();
+	return features;
+}
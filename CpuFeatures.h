@@ -0,0 +1,32 @@
+/**
+ * CpuFeatures.h
+ * Declares detection of the instruction set extensions the
+ * running CPU (and operating system) supports, so that
+ * kernels compiled for several targets may choose among
+ * themselves at run time, and the TARGET macro compiling a
+ * function for a given target.
+ *
+ * @author Sam Griffiths
+ */
+
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define CPU_X86
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#define TARGET(X)
+	#else
+		#define TARGET(X) __attribute__((target(X)))
+	#endif
+#endif
+
+//Extensions supported, for which kernels are compiled
+struct CpuFeatures
+{
+	bool ssse3;
+	bool avx2;
+};
+
+//Returns the extensions supported by the running CPU, detected on the first call (none off x86)
+const CpuFeatures& cpuFeatures();
@@ -7,137 +7,379 @@
  */
 
 #include "Cube.h"
+#include "Ranking.h"
+#include "CpuFeatures.h"
 
+#include <atomic>
+#include <cstring>
 #include <sstream>
 
-const std::unordered_map<char, std::vector<char>> Cube::sequences{
+namespace
+{
+	//Faces in the order of the move enumeration
+	constexpr char FACES[] = "UDRLFB";
+
 	/* Sequences for quarter clockwise turn (opposite faces
-		are simply the reverse sequence, but they are still
-		hard-coded here for lookup speed). */
-	{ 'U', { 'F', 'L', 'B', 'R' } },
-	{ 'D', { 'R', 'B', 'L', 'F' } },
+		are simply the reverse sequence). */
+	constexpr char SEQUENCES[6][5]{ "FLBR", "RBLF", "UBDF", "FDBU", "URDL", "LDRU" };
+}
 
-	{ 'R', { 'U', 'B', 'D', 'F' } },
-	{ 'L', { 'F', 'D', 'B', 'U' } },
+constexpr Cube::Cubie Cube::decode(size_t i, uint8_t x)
+{
+	uint8_t position = x & 15, orientation = x >> 4;
 
-	{ 'F', { 'U', 'R', 'D', 'L' } },
-	{ 'B', { 'L', 'D', 'R', 'U' } }
-};
+	//Edges are either as named or flipped
+	if (i < NUMBER_OF_EDGES)
+	{
+		const char *p = EDGE_POSITIONS[position];
+		return orientation == 0 ? Cubie(p[0], p[1]) : Cubie(p[1], p[0]);
+	}
 
-Cube::Cube()
+	//Corners are the name rotated left by the orientation
+	const char *p = CORNER_POSITIONS[position];
+	return Cubie(p[orientation], p[(orientation + 1) % 3], p[(orientation + 2) % 3]);
+}
+
+constexpr uint8_t Cube::encode(size_t i, const Cubie &c)
 {
-	//Reserves and initialises empty cubies
-	cubies.reserve(NUMBER_OF_CUBIES);
+	if (i < NUMBER_OF_EDGES)
+	{
+		for (uint8_t p = 0; p < NUMBER_OF_EDGES; p++)
+		{
+			if (c.a == EDGE_POSITIONS[p][0] && c.b == EDGE_POSITIONS[p][1])
+				return p;
+			if (c.a == EDGE_POSITIONS[p][1] && c.b == EDGE_POSITIONS[p][0])
+				return p | (1 << 4);
+		}
+	}
+	else
+	{
+		for (uint8_t p = 0; p < NUMBER_OF_CORNERS; p++)
+			for (uint8_t o = 0; o < 3; o++)
+				if (c.a == CORNER_POSITIONS[p][o] && c.b == CORNER_POSITIONS[p][(o + 1) % 3]
+					&& c.c == CORNER_POSITIONS[p][(o + 2) % 3])
+					return p | (o << 4);
+	}
 
-	while (cubies.size() < NUMBER_OF_CUBIES)
-		cubies.emplace_back();
+	throw std::ios_base::failure("Invalid cubie specification");
 }
 
-Cube::Cube(const std::string &str)
+constexpr void Cube::turn(Cubie &c, char face, int n)
 {
-	cubies.reserve(NUMBER_OF_CUBIES);
+	if (c.a != face && c.b != face && c.c != face)
+		return;
+
+	const char *seq = SEQUENCES[0];
+	for (size_t f = 0; f < 6; f++)
+		if (FACES[f] == face)
+			seq = SEQUENCES[f];
+
+	//Change each other face to the one n steps on in the sequence
+	char *letters[3]{ &c.a, &c.b, &c.c };
+	for (char *l : letters)
+		for (int i = 0; i < 4; i++)
+			if (*l == seq[i])
+			{
+				*l = seq[(i + n) % 4];
+				break;
+			}
+}
+
+constexpr Cube Cube::buildMove(size_t m)
+{
+	//Quarter turns for each of the directions +, -, 2
+	const int quarters[3]{ 1, 3, 2 };
+
+	Cube cube;
+	for (size_t i = 0; i < NUMBER_OF_CUBIES; i++)
+	{
+		Cubie c = decode(i, (i < NUMBER_OF_EDGES) ? cube.edges[i] : cube.corners[i - NUMBER_OF_EDGES]);
+		turn(c, FACES[m / 3], quarters[m % 3]);
+
+		if (i < NUMBER_OF_EDGES)
+			cube.edges[i] = encode(i, c);
+		else
+			cube.corners[i - NUMBER_OF_EDGES] = encode(i, c);
+	}
+
+	return cube;
+}
+
+const Cube Cube::MOVES[NUMBER_OF_MOVES]{
+	buildMove(0),  buildMove(1),  buildMove(2),  buildMove(3),  buildMove(4),  buildMove(5),
+	buildMove(6),  buildMove(7),  buildMove(8),  buildMove(9),  buildMove(10), buildMove(11),
+	buildMove(12), buildMove(13), buildMove(14), buildMove(15), buildMove(16), buildMove(17)
+};
 
+Cube::Cube(const std::string &str) : Cube()
+{
 	std::string buffer;
 	std::istringstream iss(str);
 
 	//Reads in cubie tokens separated by whitespace
+	size_t i = 0;
+	uint32_t positionsSeen = 0;
 	while (iss >> buffer)
 	{
-		if (buffer.length() < 2 || buffer.length() > 3)
+		//Edges come first, followed by corners
+		if (i >= NUMBER_OF_CUBIES || buffer.length() != (i < NUMBER_OF_EDGES ? 2 : 3))
 			throw std::ios_base::failure("Invalid cubie specification");
 
-		//Load each edge, deciding whether it's an edge or corner
-		cubies.emplace_back(buffer.at(0), buffer.at(1), 
-			(buffer.length() == 3) ? buffer.at(2) : 0);
+		uint8_t x = encode(i, Cubie(buffer.at(0), buffer.at(1),
+			(buffer.length() == 3) ? buffer.at(2) : 0));
+
+		//Each position must be occupied exactly once
+		uint32_t position = 1u << ((i < NUMBER_OF_EDGES ? 0 : NUMBER_OF_EDGES) + (x & 15));
+		if (positionsSeen & position)
+			throw std::ios_base::failure("Invalid cubie specification");
+		positionsSeen |= position;
+
+		if (i < NUMBER_OF_EDGES)
+			edges[i] = x;
+		else
+			corners[i - NUMBER_OF_EDGES] = x;
+		i++;
 	}
 
 	//Expect correct number of cubies
-	if (cubies.size() != NUMBER_OF_CUBIES)
+	if (i != NUMBER_OF_CUBIES)
 		throw std::ios_base::failure("Invalid cubie specification");
 }
 
 bool operator==(const Cube &lhs, const Cube &rhs)
 {
-	//Cube completely identified by vector of cubies, which implements equality
-	return lhs.cubies == rhs.cubies;
+	//Cube completely identified by its encoded cubies
+	return std::memcmp(lhs.edges, rhs.edges, sizeof(lhs.edges)) == 0
+		&& std::memcmp(lhs.corners, rhs.corners, sizeof(lhs.corners)) == 0;
 }
 
 bool Cube::compareCubie(const Cube &other, size_t cubie) const
 {
-	return cubies[cubie] == other.cubies[cubie];
+	if (cubie < NUMBER_OF_EDGES)
+		return edges[cubie] == other.edges[cubie];
+	else
+		return corners[cubie - NUMBER_OF_EDGES] == other.corners[cubie - NUMBER_OF_EDGES];
+}
+
+Cube::Cubie Cube::cubie(size_t i) const
+{
+	return decode(i, (i < NUMBER_OF_EDGES) ? edges[i] : corners[i - NUMBER_OF_EDGES]);
 }
 
 std::ostream& operator<<(std::ostream &os, const Cube &cube)
 {
-	bool first = true;
-	for (const Cube::Cubie &c : cube.cubies)
+	for (size_t i = 0; i < Cube::NUMBER_OF_CUBIES; i++)
 	{
-		if (!first) os << " ";
-		os << c.string();
-		first = false;
+		if (i != 0) os << " ";
+		os << cube.cubie(i).string();
 	}
 	return os;
 }
 
-Cube Cube::twist(char face, char dir) const
+//Ranks of the corner orientations, 3^7, the last following from the others
+static const uint32_t CORNER_ORIENTATIONS = 2187;
+
+Cube::Rank Cube::rank() const
 {
-	//Get relevant cyclic sequence
-	auto it = sequences.find(face);
+	//Positions and orientations of each piece
+	uint8_t p[NUMBER_OF_EDGES], o[NUMBER_OF_EDGES];
 
-	//Validate
-	if ((dir != '+' && dir != '-' && dir != '2') || (it == sequences.end()))
-		throw std::logic_error(std::string("Operation '") + face + dir + "' not recognised");
-	
-	const std::vector<char> &seq = it->second;
+	for (size_t i = 0; i < NUMBER_OF_CORNERS; i++)
+	{
+		p[i] = corners[i] & 15;
+		o[i] = corners[i] >> 4;
+	}
+	uint32_t c = uint32_t(rankPositions(p, NUMBER_OF_CORNERS, NUMBER_OF_CORNERS) * CORNER_ORIENTATIONS
+		+ rankDigits(o, NUMBER_OF_CORNERS - 1, 3));
 
-	//Utility function applies operation to specified cubie face
-	auto apply = [&seq, &dir](char &c)
+	for (size_t i = 0; i < NUMBER_OF_EDGES; i++)
 	{
-		//Find in sequence
-		auto it = std::find(seq.begin(), seq.end(), c);
-		if (it == seq.end())
-			throw std::logic_error("Impossible face/operation combination");
+		p[i] = edges[i] & 15;
+		o[i] = edges[i] >> 4;
+	}
+	uint64_t e = uint64_t(rankPositions(p, NUMBER_OF_EDGES, NUMBER_OF_EDGES)) << (NUMBER_OF_EDGES - 1)
+		| rankDigits(o, NUMBER_OF_EDGES - 1, 2);
+
+	return { c, e };
+}
+
+Cube Cube::unrank(const Rank &r)
+{
+	Cube cube;
+	uint8_t p[NUMBER_OF_EDGES], o[NUMBER_OF_EDGES];
+
+	unrankPositions(r.corners / CORNER_ORIENTATIONS, p, NUMBER_OF_CORNERS, NUMBER_OF_CORNERS);
+	unrankDigits(r.corners % CORNER_ORIENTATIONS, o, NUMBER_OF_CORNERS - 1, 3);
+
+	uint8_t sum = 0;
+	for (size_t i = 0; i < NUMBER_OF_CORNERS - 1; i++)
+	{
+		cube.corners[i] = uint8_t(p[i] | o[i] << 4);
+		sum += o[i];
+	}
+	cube.corners[NUMBER_OF_CORNERS - 1] = uint8_t(p[NUMBER_OF_CORNERS - 1] | (3 - sum % 3) % 3 << 4);
 
-		//Change to next/previous in sequence
-		if (dir == '-')
+	unrankPositions(size_t(r.edges >> (NUMBER_OF_EDGES - 1)), p, NUMBER_OF_EDGES, NUMBER_OF_EDGES);
+	unrankDigits(size_t(r.edges & ((1u << (NUMBER_OF_EDGES - 1)) - 1)), o, NUMBER_OF_EDGES - 1, 2);
+
+	sum = 0;
+	for (size_t i = 0; i < NUMBER_OF_EDGES - 1; i++)
+	{
+		cube.edges[i] = uint8_t(p[i] | o[i] << 4);
+		sum += o[i];
+	}
+	cube.edges[NUMBER_OF_EDGES - 1] = uint8_t(p[NUMBER_OF_EDGES - 1] | sum % 2 << 4);
+
+	return cube;
+}
+
+Cube::Move Cube::move(char face, char dir)
+{
+	for (size_t m = 0; m < NUMBER_OF_MOVES; m++)
+		if (MOVE_NAMES[m][0] == face && MOVE_NAMES[m][1] == dir)
+			return Move(m);
+
+	throw std::logic_error(std::string("Operation '") + face + dir + "' not recognised");
+}
+
+Cube Cube::twist(char face, char dir) const
+{
+	return twist(move(face, dir));
+}
+
+namespace
+{
+	//Kernel composing a sequence onto a state
+	using ApplyKernel = void(*)(const Cube &cube, const Cube &sequence, Cube &result);
+
+	void applyScalar(const Cube &cube, const Cube &sequence, Cube &result)
+	{
+		//Each cubie moves to where the sequence takes its position,
+		//adding the orientation change at that position
+		for (size_t i = 0; i < Cube::NUMBER_OF_EDGES; i++)
 		{
-			if (it == seq.begin())
-				it = seq.end();
-			--it;
+			uint8_t x = cube.edges[i];
+			result.edges[i] = sequence.edges[x & 15] ^ (x & 0xF0);
 		}
-		else
+
+		for (size_t i = 0; i < Cube::NUMBER_OF_CORNERS; i++)
 		{
-			++it;
-			if (it == seq.end())
-				it = seq.begin();
+			uint8_t x = cube.corners[i];
+			x = sequence.corners[x & 15] + (x & 0xF0);
+			result.corners[i] = x - 0x30 * (x >= 0x30);
 		}
+	}
 
-		c = *it;
+#ifdef CPU_X86
+	/* The vector kernels shuffle the sequence by each cubie's position,
+		add the cubie's orientation, then reduce modulo 2 (edges) or
+		3 (corners) by taking the lesser of x and x - modulus. Padding
+		bytes are cleared again afterwards. */
+	alignas(32) const uint8_t MODULUS[32]{
+		0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+		0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30
+	};
+	alignas(32) const uint8_t PADDING_MASK[32]{
+		0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0,
+		0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0, 0, 0, 0, 0
 	};
 
-	//Iterate over cloned child, applying operation where applicable
-	Cube cube(*this);
+	TARGET("ssse3")
+	void applySSSE3(const Cube &cube, const Cube &sequence, Cube &result)
+	{
+		const __m128i orientation = _mm_set1_epi8(0x30);
 
-	int num = dir == '2' ? 2 : 1;
-	for (int i = 0; i < num; ++i)
-		for (Cubie &c : cube.cubies)
+		for (size_t i = 0; i < 2; i++)
 		{
-			if (c.a == face)
-			{
-				apply(c.b);
-				if (c.c != 0) apply(c.c);
-			}
-			else if (c.b == face)
-			{
-				apply(c.a);
-				if (c.c != 0) apply(c.c);
-			}
-			else if (c.c == face)
-			{
-				apply(c.a);
-				apply(c.b);
-			}
+			__m128i x = _mm_load_si128(reinterpret_cast<const __m128i*>(&cube) + i);
+			__m128i s = _mm_load_si128(reinterpret_cast<const __m128i*>(&sequence) + i);
+
+			__m128i v = _mm_add_epi8(_mm_shuffle_epi8(s, x), _mm_and_si128(x, orientation));
+			v = _mm_min_epu8(v, _mm_sub_epi8(v, _mm_load_si128(reinterpret_cast<const __m128i*>(MODULUS) + i)));
+			v = _mm_and_si128(v, _mm_load_si128(reinterpret_cast<const __m128i*>(PADDING_MASK) + i));
+
+			_mm_store_si128(reinterpret_cast<__m128i*>(&result) + i, v);
 		}
+	}
+
+	TARGET("avx2")
+	void applyAVX2(const Cube &cube, const Cube &sequence, Cube &result)
+	{
+		//Cubes are copied as 16-byte halves elsewhere, so load and store them
+		//the same way to keep store forwarding
+		const __m128i *c = reinterpret_cast<const __m128i*>(&cube);
+		__m256i x = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_load_si128(c)), _mm_load_si128(c + 1), 1);
+		__m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&sequence));
+
+		//Shuffles stay within each 16-byte lane, i.e. edges and corners separately
+		__m256i v = _mm256_add_epi8(_mm256_shuffle_epi8(s, x), _mm256_and_si256(x, _mm256_set1_epi8(0x30)));
+		v = _mm256_min_epu8(v, _mm256_sub_epi8(v, _mm256_load_si256(reinterpret_cast<const __m256i*>(MODULUS))));
+		v = _mm256_and_si256(v, _mm256_load_si256(reinterpret_cast<const __m256i*>(PADDING_MASK)));
+
+		__m128i *r = reinterpret_cast<__m128i*>(&result);
+		_mm_store_si128(r, _mm256_castsi256_si128(v));
+		_mm_store_si128(r + 1, _mm256_extracti128_si256(v, 1));
+	}
+#endif
+
+	//Chooses the best kernel supported by this CPU
+	ApplyKernel selectApplyKernel(const char *&name)
+	{
+#ifdef CPU_X86
+		const CpuFeatures &features = cpuFeatures();
+
+		if (features.avx2)
+		{
+			name = "AVX2";
+			return applyAVX2;
+		}
+		if (features.ssse3)
+		{
+			name = "SSSE3";
+			return applySSSE3;
+		}
+#endif
+		name = "scalar";
+		return applyScalar;
+	}
+
+	void applyResolve(const Cube &cube, const Cube &sequence, Cube &result);
+
+	//Starts at the resolver, which swaps itself out for the selected kernel on first use
+	std::atomic<ApplyKernel> applyKernel(applyResolve);
+
+	void applyResolve(const Cube &cube, const Cube &sequence, Cube &result)
+	{
+		const char *name;
+		applyKernel.store(selectApplyKernel(name), std::memory_order_relaxed);
+		applyKernel.load(std::memory_order_relaxed)(cube, sequence, result);
+	}
+}
+
+Cube Cube::apply(const Cube &sequence) const
+{
+	Cube cube;
+	applyKernel.load(std::memory_order_relaxed)(*this, sequence, cube);
+	return cube;
+}
+
+Cube Cube::inverse() const
+{
+	Cube cube;
+
+	//Piece i at position p becomes piece p at position i, its orientation negated
+	for (size_t i = 0; i < NUMBER_OF_EDGES; i++)
+		cube.edges[edges[i] & 15] = uint8_t(i | (edges[i] & 0xF0));
+
+	for (size_t i = 0; i < NUMBER_OF_CORNERS; i++)
+		cube.corners[corners[i] & 15] = uint8_t(i | ((3 - (corners[i] >> 4)) % 3 << 4));
 
 	return cube;
 }
+
+const char* Cube::applyKernelName()
+{
+	const char *name;
+	selectApplyKernel(name);
+	return name;
+}
@@ -8,22 +8,23 @@
 
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <string>
-#include <vector>
-#include <unordered_map>
 
-struct Cube
+struct alignas(16) Cube
 {
-	//Represents an individual cubie, which can be an edge or corner piece
+	//Represents an individual cubie by its face letters, used only
+	//when converting to and from the string representation
 	struct Cubie
 	{
 		char a; //First face
 		char b; //Second face
 		char c; //Third face; zero if edge piece
 
-		Cubie(char a, char b, char c) : a(a), b(b), c(c) {}
-		Cubie(char a, char b) : Cubie(a, b, 0) {}
-		Cubie() : Cubie(0, 0, 0) {}
+		constexpr Cubie(char a, char b, char c) : a(a), b(b), c(c) {}
+		constexpr Cubie(char a, char b) : Cubie(a, b, 0) {}
+		constexpr Cubie() : Cubie(0, 0, 0) {}
 
 		friend bool operator==(const Cubie &lhs, const Cubie &rhs) {
 			return lhs.a == rhs.a && lhs.b == rhs.b && lhs.c == rhs.c;
@@ -33,32 +34,138 @@ struct Cube
 			std::string s; s += a; s += b; if (c != 0) s += c; return s;
 		}
 	};
-	//Flat list of cubies in order
-	std::vector<Cubie> cubies;
+
+	/* Each cubie is identified by its goal position (in the order of the
+		goal string) and encoded in one byte: the low nibble holds the
+		position it currently occupies, the high nibble its orientation
+		relative to that position (0-1 for edges, 0-2 for corners). Each
+		list is zero-padded to 16 bytes to fill a vector register. */
+	uint8_t edges[16];
+	uint8_t corners[16];
 
 	//Number of cubies expected to represent a Cube
 	static const size_t NUMBER_OF_CUBIES = 20;
+	static const size_t NUMBER_OF_EDGES = 12;
+	static const size_t NUMBER_OF_CORNERS = 8;
+
+	//Face letters of each position, in the order of the goal string
+	static constexpr char EDGE_POSITIONS[NUMBER_OF_EDGES][3]{
+		"UF", "UR", "UB", "UL", "DF", "DR", "DB", "DL", "FR", "FL", "BR", "BL"
+	};
+	static constexpr char CORNER_POSITIONS[NUMBER_OF_CORNERS][4]{
+		"UFR", "URB", "UBL", "ULF", "DRF", "DFL", "DLB", "DBR"
+	};
 
-	//Defines the possible operations on a cube as cyclic sequences
-	static const std::unordered_map<char, std::vector<char>> sequences;
+	//Enumerates the face turns, ordered by face (U D R L F B) then direction (+ - 2)
+	enum Move : uint8_t
+	{
+		U_PLUS, U_MINUS, U_TWO,
+		D_PLUS, D_MINUS, D_TWO,
+		R_PLUS, R_MINUS, R_TWO,
+		L_PLUS, L_MINUS, L_TWO,
+		F_PLUS, F_MINUS, F_TWO,
+		B_PLUS, B_MINUS, B_TWO
+	};
 
+	//Number of distinct face turns
+	static const size_t NUMBER_OF_MOVES = 18;
+
+	//String representation of each move
+	static constexpr char MOVE_NAMES[NUMBER_OF_MOVES][3]{
+		"U+", "U-", "U2", "D+", "D-", "D2", "R+", "R-", "R2",
+		"L+", "L-", "L2", "F+", "F-", "F2", "B+", "B-", "B2"
+	};
+
+	//The state reached by applying each move to the solved Cube
+	static const Cube MOVES[NUMBER_OF_MOVES];
+
+	/* Perfect rank of a Cube state, with the corners (permutation rank
+		* 3^7 + orientation) and edges (permutation rank * 2^11 + flips)
+		ranked separately: together they span some 2^65 states, too many
+		for a single 64-bit word. The corner rank is also the corner
+		pattern database index. */
+	struct Rank
+	{
+		uint32_t corners;
+		uint64_t edges;
 
-	//Default constructor initialises void cubies
-	Cube();
+		friend bool operator==(const Rank &lhs, const Rank &rhs) {
+			return lhs.corners == rhs.corners && lhs.edges == rhs.edges;
+		}
+	};
+
+	//Number of distinct corner and edge ranks
+	static const uint32_t CORNER_RANKS = 88179840;
+	static const uint64_t EDGE_RANKS = 980995276800;
+
+
+	//Default constructor initialises the solved state
+	constexpr Cube() : edges{ 0,1,2,3,4,5,6,7,8,9,10,11 }, corners{ 0,1,2,3,4,5,6,7 } {}
 	//Instantiates cubies from the string representation provided
 	Cube(const std::string &str);
 
 	//Cubes are equal if their 20-cubie representations are the same
 	friend bool operator==(const Cube &lhs, const Cube &rhs);
-	
+
 	//Compares the given cube based solely on the given cubie
 	bool compareCubie(const Cube &other, size_t cubie) const;
 
+	//Returns the face letter representation of the given cubie
+	Cubie cubie(size_t i) const;
+
 	//Outputs 20-cubie representation
 	friend std::ostream& operator<<(std::ostream &os, const Cube &cube);
 
+	//Returns the move code of the given face and dir (+,-,2)
+	static Move move(char face, char dir);
+
 	//Returns a new Cube state having twisted the given face in the given dir (+,-,2)
 	Cube twist(char face, char dir) const;
+
+	//Returns a new Cube state having applied the given move
+	Cube twist(Move m) const { return apply(MOVES[m]); }
+
+	//Returns a new Cube state having applied the twists which take
+	//the solved Cube to the given state (vectorised where supported)
+	Cube apply(const Cube &sequence) const;
+
+	/* Returns the inverse state, reached by undoing this state's twists
+		from the solved Cube: where this state takes piece i to position p,
+		the inverse takes piece p to position i, undoing its orientation.
+		It lies as far from the solved Cube as this state does. */
+	Cube inverse() const;
+
+	//Returns the move undoing the given move
+	static constexpr Move inverse(Move m) { return (m % 3 == 2) ? m : Move(m - m % 3 + 1 - m % 3); }
+
+	//Names the instruction set used by apply on this machine
+	static const char* applyKernelName();
+
+	//Returns the perfect rank of this Cube state
+	Rank rank() const;
+
+	//Returns the Cube state of the given rank
+	static Cube unrank(const Rank &r);
+
+	//Scrambles the bits of a word, so that nearby words hash far apart
+	static constexpr uint64_t mix(uint64_t x)
+	{
+		//SplitMix64 finaliser
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+		return x ^ (x >> 31);
+	}
+
+private:
+	//Converts between face letters and the encoded byte of the given cubie
+	static constexpr Cubie decode(size_t i, uint8_t x);
+	static constexpr uint8_t encode(size_t i, const Cubie &c);
+
+	//Relabels the faces of a cubie as the given face is turned clockwise n times
+	static constexpr void turn(Cubie &c, char face, int n);
+
+	//Builds the state reached by applying the given move to the solved Cube
+	static constexpr Cube buildMove(size_t m);
 };
 
 
@@ -76,15 +183,27 @@ struct std::hash<Cube::Cubie>
 	}
 };
 
+template<>
+struct std::hash<Cube::Rank>
+{
+	size_t operator()(const Cube::Rank &r) const noexcept
+	{
+		return size_t(Cube::mix(r.edges ^ Cube::mix(r.corners)));
+	}
+};
+
 template<>
 struct std::hash<Cube>
 {
 	size_t operator()(const Cube &c) const noexcept
 	{
-		//Bernstein hash
-		size_t hash = 5381;
-		for (const Cube::Cubie &cubie : c.cubies)
-			hash = hash * 33 + std::hash<Cube::Cubie>()(cubie);
-		return hash;
+		//The encoded cubies identify the state as uniquely as its rank, and are
+		//far cheaper to mix: 12 edge bytes and 8 corner bytes as three words
+		uint64_t edgesLow, corners;
+		uint32_t edgesHigh;
+		std::memcpy(&edgesLow, c.edges, sizeof(edgesLow));
+		std::memcpy(&edgesHigh, c.edges + sizeof(edgesLow), sizeof(edgesHigh));
+		std::memcpy(&corners, c.corners, sizeof(corners));
+		return size_t(Cube::mix(corners ^ Cube::mix(edgesLow ^ Cube::mix(edgesHigh))));
 	}
 };
@@ -14,10 +14,39 @@ struct CubeNode
 {
 	Cube cube;
 
+	//Number of operations (moves) applicable to a node
+	static const Search::Operation OPERATIONS = Cube::NUMBER_OF_MOVES;
 
-	CubeNode(Cube cube) : cube(cube) {}
 
-	std::vector<Search::Edge<CubeNode>> expand() const;
+	CubeNode(Cube cube = Cube()) : cube(cube) {}
+
+	//Visits the child of each move in turn, with the move as its operation
+	template <typename Visitor>
+	void expand(Visitor &&visit) const
+	{
+		for (Search::Operation op = 0; op < OPERATIONS; op++)
+			visit(apply(op), op);
+	}
+
+	//Returns the child reached by the given move
+	CubeNode apply(Search::Operation op) const
+	{
+		return CubeNode(cube.twist(Cube::Move(op)));
+	}
+
+	//Keyed node stores keep each by its rank, half the size of the Cube (see NodeStore)
+	using Key = Cube::Rank;
+	Key key() const { return cube.rank(); }
+	static CubeNode fromKey(const Key &k) { return CubeNode(Cube::unrank(k)); }
+
+	/* A move is redundant after one of the same face, or after one of
+		the opposite face if it would undo their canonical order (faces
+		are paired U/D, R/L, F/B in move order). */
+	static bool redundant(Search::Operation previous, Search::Operation op)
+	{
+		size_t face = op / 3, previousFace = previous / 3;
+		return face / 2 == previousFace / 2 && face <= previousFace;
+	}
 
 	friend bool operator==(const CubeNode &lhs, const CubeNode &rhs);
 	friend std::ostream& operator<<(std::ostream &os, const CubeNode &cubeNode);
@@ -20,7 +20,7 @@ namespace Search
 
 		//Stack of nodes to be expanded
 		std::deque<DFSNode> open;
-		open.push_front({ {start,""}, 0 });
+		open.push_front({ { start, 0 }, 0 });
 
 		//Current search path
 		std::vector<DFSNode> trace;
@@ -58,20 +58,20 @@ namespace Search
 				bool anyChildren = false;
 				if (d < depthLimit)
 				{
-					for (const Edge<Node> &c : n.first.first.expand())
+					n.first.first.expand([&](const Node &c, Operation op)
 					{
 						//Only add if not in current path (i.e. does not form a cycle)
 						bool cycle = false;
 						for (const auto &x : trace)
-							if (x.first.first == c.first)
+							if (x.first.first == c)
 								cycle = true;
 
 						if (!cycle)
 						{
-							open.push_front({ c, d + 1 });
+							open.push_front({ { c, op }, d + 1 });
 							anyChildren = true;
 						}
-					}
+					});
 				}
 
 				//Add to path (if not backtracking)
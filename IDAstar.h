@@ -14,12 +14,21 @@ namespace Search
 {
 	template <typename Node>
 	Path IDAstar(const Node &start, const Node &goal, HeuristicFunc<Node> h)
+	{
+		return IDAstar(start, goal, FixedGoalHeuristic<Node>{ h, goal });
+	}
+
+	template <typename Node, typename Heuristic>
+	Path IDAstar(const Node &start, const Node &goal, const Heuristic &h)
 	{
 		//Associate nodes with preceding edge and depth
 		using IDANode = std::pair<Edge<Node>, size_t>;
 
+		//Costs are in the heuristic's own type, widened to hold depths
+		using Cost = typename std::common_type<decltype(h(start)), size_t>::type;
+
 		//Current heuristic depth limit
-		double threshold = h(start, goal);
+		Cost threshold = h(start);
 
 		//Current search path
 		std::vector<IDANode> trace;
@@ -29,11 +38,11 @@ namespace Search
 		while (!found)
 		{
 			//Tracker for the minimum of pruned costs
-			double thresholdNew = std::numeric_limits<double>::infinity();
+			Cost thresholdNew = std::numeric_limits<Cost>::max();
 
 			//Stack of nodes to be expanded
 			std::deque<IDANode> open;
-			open.push_front({ { start,"" }, 0 });
+			open.push_front({ { start, 0 }, 0 });
 
 			//Ensure trace is reset
 			trace.clear();
@@ -68,9 +77,9 @@ namespace Search
 
 					//Get the node's children
 					bool anyChildren = false;
-					for (const Edge<Node> &c : n.first.first.expand())
+					n.first.first.expand([&](const Node &c, Operation op)
 					{
-						double cost = d + 1 + h(c.first, goal);
+						Cost cost = d + 1 + h(c);
 
 						//If below the threshold, add
 						if (cost <= threshold)
@@ -78,12 +87,12 @@ namespace Search
 							//Only add if not in current path (i.e. does not form a cycle)
 							bool cycle = false;
 							for (const auto &x : trace)
-								if (x.first.first == c.first)
+								if (x.first.first == c)
 									cycle = true;
 
 							if (!cycle)
 							{
-								open.push_front({ c, d + 1 });
+								open.push_front({ { c, op }, d + 1 });
 								anyChildren = true;
 							}
 						}
@@ -91,7 +100,7 @@ namespace Search
 						//Else, prune and log minimum
 						else if (cost < thresholdNew)
 							thresholdNew = cost;
-					}
+					});
 
 					//Add to path (if not backtracking)
 					if (anyChildren)
@@ -0,0 +1,158 @@
+/**
+ * ManhattanTable.cpp
+ * Implements the ManhattanTable, a flat table of the number
+ * of face turns between any two states of a single piece.
+ *
+ * @author Sam Griffiths
+ */
+
+#include "ManhattanTable.h"
+#include "CpuFeatures.h"
+
+#include <atomic>
+#include <deque>
+
+namespace
+{
+	//Fills the distances from each state, where next(state, move) gives the state a move leads to
+	template <typename Next>
+	void generateDistances(uint8_t (&table)[ManhattanTable::STATES][ManhattanTable::STATES], Next next)
+	{
+		for (size_t from = 0; from < ManhattanTable::STATES; from++)
+		{
+			bool seen[ManhattanTable::STATES] = { false };
+			seen[from] = true;
+			table[from][from] = 0;
+
+			std::deque<uint8_t> open{ uint8_t(from) };
+			while (!open.empty())
+			{
+				uint8_t s = open.front();
+				open.pop_front();
+
+				for (size_t m = 0; m < Cube::NUMBER_OF_MOVES; m++)
+				{
+					uint8_t t = next(s, Cube::MOVES[m]);
+					if (!seen[t])
+					{
+						seen[t] = true;
+						table[from][t] = uint8_t(table[from][s] + 1);
+						open.push_back(t);
+					}
+				}
+			}
+		}
+	}
+
+	using SumKernel = ManhattanTable::Sums (*)(const ManhattanTable &table, const Cube &cube);
+
+	ManhattanTable::Sums sumScalar(const ManhattanTable &table, const Cube &cube)
+	{
+		ManhattanTable::Sums sums{ 0, 0 };
+
+		for (size_t i = 0; i < Cube::NUMBER_OF_EDGES; i++)
+			sums.edges += table.edges[i][ManhattanTable::edgeState(cube.edges[i])];
+
+		for (size_t i = 0; i < Cube::NUMBER_OF_CORNERS; i++)
+			sums.corners += table.corners[i][ManhattanTable::cornerState(cube.corners[i])];
+
+		return sums;
+	}
+
+#ifdef CPU_X86
+	/* Each piece reads a different row, so no byte shuffle can do the
+		lookups; instead the byte offsets (row * 24 + state) are gathered
+		as 32-bit words, of which only the low byte is kept. Reads of the
+		last rows run on into the rows after, which stay within the table. */
+	TARGET("avx2")
+	ManhattanTable::Sums sumAVX2(const ManhattanTable &table, const Cube &cube)
+	{
+		const int *edges = reinterpret_cast<const int*>(table.edges);
+		const int *corners = reinterpret_cast<const int*>(table.corners);
+		const __m256i rows = _mm256_setr_epi32(0, 24, 48, 72, 96, 120, 144, 168);
+		const __m128i lastRows = _mm_setr_epi32(192, 216, 240, 264);
+		const __m256i lowByte = _mm256_set1_epi32(0xFF);
+
+		__m128i e = _mm_load_si128(reinterpret_cast<const __m128i*>(cube.edges));
+		__m128i c = _mm_load_si128(reinterpret_cast<const __m128i*>(cube.corners));
+
+		//State = position + orientation * 12 (edges) or * 8 (corners)
+		__m256i e0 = _mm256_cvtepu8_epi32(e), e1 = _mm256_cvtepu8_epi32(_mm_srli_si128(e, 8));
+		__m256i c0 = _mm256_cvtepu8_epi32(c);
+		__m256i f0 = _mm256_srli_epi32(e0, 4), f1 = _mm256_srli_epi32(e1, 4), t0 = _mm256_srli_epi32(c0, 4);
+		e0 = _mm256_add_epi32(_mm256_and_si256(e0, _mm256_set1_epi32(15)),
+			_mm256_add_epi32(_mm256_slli_epi32(f0, 3), _mm256_slli_epi32(f0, 2)));
+		e1 = _mm256_add_epi32(_mm256_and_si256(e1, _mm256_set1_epi32(15)),
+			_mm256_add_epi32(_mm256_slli_epi32(f1, 3), _mm256_slli_epi32(f1, 2)));
+		c0 = _mm256_add_epi32(_mm256_and_si256(c0, _mm256_set1_epi32(15)), _mm256_slli_epi32(t0, 3));
+
+		//Edges 0-7 and 8-11, then corners 0-7
+		__m256i d0 = _mm256_and_si256(_mm256_i32gather_epi32(edges, _mm256_add_epi32(e0, rows), 1), lowByte);
+		__m128i d1 = _mm_and_si128(_mm_i32gather_epi32(edges, _mm_add_epi32(_mm256_castsi256_si128(e1), lastRows), 1),
+			_mm256_castsi256_si128(lowByte));
+		__m256i d2 = _mm256_and_si256(_mm256_i32gather_epi32(corners, _mm256_add_epi32(c0, rows), 1), lowByte);
+
+		__m128i edgeSum = _mm_add_epi32(_mm_add_epi32(_mm256_castsi256_si128(d0), _mm256_extracti128_si256(d0, 1)), d1);
+		__m128i cornerSum = _mm_add_epi32(_mm256_castsi256_si128(d2), _mm256_extracti128_si256(d2, 1));
+		__m128i s = _mm_hadd_epi32(edgeSum, cornerSum);
+		s = _mm_hadd_epi32(s, s);
+
+		return { uint32_t(_mm_cvtsi128_si32(s)), uint32_t(_mm_extract_epi32(s, 1)) };
+	}
+#endif
+
+	//Chooses the best kernel supported by this CPU
+	SumKernel selectSumKernel(const char *&name)
+	{
+#ifdef CPU_X86
+		const CpuFeatures &features = cpuFeatures();
+
+		if (features.avx2)
+		{
+			name = "AVX2";
+			return sumAVX2;
+		}
+#endif
+		name = "scalar";
+		return sumScalar;
+	}
+
+	ManhattanTable::Sums sumResolve(const ManhattanTable &table, const Cube &cube);
+
+	//Starts at the resolver, which swaps itself out for the selected kernel on first use
+	std::atomic<SumKernel> sumKernel(sumResolve);
+
+	ManhattanTable::Sums sumResolve(const ManhattanTable &table, const Cube &cube)
+	{
+		const char *name;
+		sumKernel.store(selectSumKernel(name), std::memory_order_relaxed);
+		return sumKernel.load(std::memory_order_relaxed)(table, cube);
+	}
+}
+
+ManhattanTable::ManhattanTable()
+{
+	//Edges change position by the move and flip by its orientation change
+	generateDistances(edges, [](uint8_t s, const Cube &move) {
+		uint8_t x = move.edges[s % Cube::NUMBER_OF_EDGES];
+		return uint8_t((x & 15) + Cube::NUMBER_OF_EDGES * ((s / Cube::NUMBER_OF_EDGES) ^ (x >> 4)));
+	});
+
+	//Corners likewise, twisting modulo 3
+	generateDistances(corners, [](uint8_t s, const Cube &move) {
+		uint8_t x = move.corners[s % Cube::NUMBER_OF_CORNERS];
+		return uint8_t((x & 15) + Cube::NUMBER_OF_CORNERS * ((s / Cube::NUMBER_OF_CORNERS + (x >> 4)) % 3));
+	});
+}
+
+ManhattanTable::Sums ManhattanTable::sum(const Cube &cube) const
+{
+	return sumKernel.load(std::memory_order_relaxed)(*this, cube);
+}
+
+const char* ManhattanTable::sumKernelName()
+{
+	const char *name;
+	selectSumKernel(name);
+	return name;
+}
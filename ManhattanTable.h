@@ -0,0 +1,49 @@
+/**
+ * ManhattanTable.h
+ * Declares the ManhattanTable, a flat table of the number of
+ * face turns between any two states of a single edge or
+ * corner piece, from which the Manhattan distance heuristic
+ * is summed.
+ *
+ * @author Sam Griffiths
+ */
+
+#pragma once
+
+#include "Cube.h"
+
+#include <cstdint>
+
+/* A piece's state is its position and orientation, numbered
+	position + orientation * (number of positions), so that 24 states
+	cover either kind of piece and the goal state of piece i is i. */
+struct alignas(32) ManhattanTable
+{
+	//Number of states of an edge (12 positions, 2 flips) or corner (8 positions, 3 twists)
+	static const size_t STATES = 24;
+
+	//(From state, to state) -> face turns between them
+	uint8_t edges[STATES][STATES];
+	uint8_t corners[STATES][STATES];
+
+	//Sums of the distances of every edge, and of every corner, from its goal state
+	struct Sums
+	{
+		uint32_t edges;
+		uint32_t corners;
+	};
+
+
+	//Default constructor generates the distances by breadth-first search from each state
+	ManhattanTable();
+
+	//Returns the state of the given encoded edge or corner byte
+	static uint8_t edgeState(uint8_t x) { return uint8_t((x & 15) + Cube::NUMBER_OF_EDGES * (x >> 4)); }
+	static uint8_t cornerState(uint8_t x) { return uint8_t((x & 15) + Cube::NUMBER_OF_CORNERS * (x >> 4)); }
+
+	//Returns the distance sums of the given Cube (vectorised where supported)
+	Sums sum(const Cube &cube) const;
+
+	//Names the instruction set used by sum on this machine
+	static const char* sumKernelName();
+};
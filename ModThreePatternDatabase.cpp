@@ -0,0 +1,40 @@
+/**
+ * ModThreePatternDatabase.cpp
+ * Implements the ModThreePatternDatabase class, a read-only
+ * table holding each heuristic value modulo 3 in 2 bits.
+ *
+ * @author Sam Griffiths
+ */
+
+#include "ModThreePatternDatabase.h"
+
+#include <utility>
+#include <vector>
+
+ModThreePatternDatabase::ModThreePatternDatabase(const PatternDatabase &pd, size_t n)
+	: n(n)
+{
+	std::vector<FourBitIntPair> entries(bytes(n));
+
+	for (size_t i = 0; i < n; i++)
+	{
+		const FourBitIntPair &pair = pd[i / 2];
+		uint8_t value = (i % 2 == 0) ? pair.a() : pair.b();
+		entries[i / 4].x |= uint8_t(value % 3 << (i % 4 * 2));
+	}
+
+	packed = PatternDatabase(std::move(entries));
+}
+
+ModThreePatternDatabase ModThreePatternDatabase::map(const std::string &path, size_t n)
+{
+	ModThreePatternDatabase pd;
+	pd.packed = PatternDatabase::map(path, 2 * bytes(n));
+	pd.n = n;
+	return pd;
+}
+
+void ModThreePatternDatabase::write(std::ostream &os) const
+{
+	os.write(reinterpret_cast<const char*>(entries()), std::streamsize(bytes(n)));
+}
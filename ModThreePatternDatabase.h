@@ -0,0 +1,105 @@
+/**
+ * ModThreePatternDatabase.h
+ * Declares the ModThreePatternDatabase class, a read-only
+ * table holding each heuristic value modulo 3 in 2 bits.
+ * Neighbouring states differ in value by at most 1, so a
+ * value follows from the residue once a neighbour's value
+ * is known, and any value can be recovered by descending
+ * to the goal. The packed values may be written out, and
+ * mapped straight from that file, never holding the 4-bit
+ * values they were reduced from.
+ *
+ * @author Sam Griffiths
+ */
+
+#pragma once
+
+#include "PatternDatabase.h"
+#include "Cube.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <xmmintrin.h>
+#endif
+
+class ModThreePatternDatabase
+{
+public:
+	//Default constructor gives an empty database
+	ModThreePatternDatabase() : n(0) {}
+
+	//Reduces the given database of n 4-bit values
+	ModThreePatternDatabase(const PatternDatabase &pd, size_t n);
+
+	//Maps the given file of n 2-bit values, as written by write, read-only
+	//(throws std::ios_base::failure if unable)
+	static ModThreePatternDatabase map(const std::string &path, size_t n);
+
+	//Writes out the packed values
+	void write(std::ostream &os) const;
+
+	//Returns the value at the given index, modulo 3
+	uint8_t operator[](size_t i) const { return (entries()[i / 4].x >> (i % 4 * 2)) & 3; }
+
+	//Returns the value at the given index, given the value at a neighbouring index
+	uint8_t value(size_t i, uint8_t neighbour) const
+	{
+		//Residue difference 0, 1 or 2 means the same, one more or one less
+		static const int8_t CHANGE[3][3] = { { 0, -1, 1 }, { 1, 0, -1 }, { -1, 1, 0 } };
+		return uint8_t(neighbour + CHANGE[(*this)[i]][neighbour % 3]);
+	}
+
+	//Returns the value of the given Cube by counting the moves down to the
+	//goal index, where index(cube) gives the index of a Cube
+	template <typename Index>
+	uint8_t value(Cube cube, size_t goal, Index index) const
+	{
+		uint8_t steps = 0;
+
+		for (size_t i = index(cube); i != goal; steps++)
+		{
+			//Any neighbour one less modulo 3 is one closer to the goal
+			uint8_t below = ((*this)[i] + 2) % 3;
+			size_t m = 0, next = 0;
+			for (; m < Cube::NUMBER_OF_MOVES; m++)
+				if ((*this)[next = index(cube.twist(Cube::Move(m)))] == below)
+					break;
+
+			//None can only mean the table is inconsistent
+			if (m == Cube::NUMBER_OF_MOVES)
+				break;
+
+			cube = cube.twist(Cube::Move(m));
+			i = next;
+		}
+
+		return steps;
+	}
+
+	//Hints that the value at the given index is about to be read
+	void prefetch(size_t i) const
+	{
+	#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		_mm_prefetch(reinterpret_cast<const char*>(entries() + i / 4), _MM_HINT_T0);
+	#elif defined(__GNUC__)
+		__builtin_prefetch(entries() + i / 4);
+	#endif
+	}
+
+	//Number of values
+	size_t size() const { return n; }
+
+private:
+	//Values packed four to a byte, least significant first, held (or mapped)
+	//as a PatternDatabase of twice as many 4-bit values
+	PatternDatabase packed;
+	size_t n;
+
+	const FourBitIntPair* entries() const { return packed.data(); }
+
+	//Number of bytes holding n values
+	static size_t bytes(size_t n) { return (n + 3) / 4; }
+};
@@ -0,0 +1,155 @@
+/**
+ * NodeStore.h
+ * Implements an arena holding each node of a search once,
+ * along with the index of its parent and the operation
+ * leading from it. Nodes are kept in fixed-size chunks so
+ * they never move, and are found again through an open
+ * addressing table of their indices. A store may instead be
+ * keyed, for a node type defining a Key type, key() and
+ * fromKey(key): each node is then kept in that more compact
+ * form, and hashed and compared by it, trading the time
+ * taken to convert each node for memory.
+ *
+ * @author Sam Griffiths
+ */
+
+#ifndef NodeStore_H
+#define NodeStore_H
+
+#include "Search.h"
+
+namespace Search
+{
+	//The form a node is kept in: itself, or its Key if the store is keyed
+	template <typename Node, bool Keyed>
+	struct StoredNode
+	{
+		using Type = Node;
+		static const Node& store(const Node &n) { return n; }
+		static const Node& load(const Node &n) { return n; }
+	};
+
+	template <typename Node>
+	struct StoredNode<Node, true>
+	{
+		using Type = typename Node::Key;
+		static Type store(const Node &n) { return n.key(); }
+		static Node load(const Type &k) { return Node::fromKey(k); }
+	};
+
+	template <typename Node, bool Keyed>
+	class NodeStore
+	{
+		using Form = StoredNode<Node, Keyed>;
+		using Stored = typename Form::Type;
+
+	public:
+		//Nodes are referred to by their order of insertion
+		using Index = uint32_t;
+
+		//Index denoting no node (the parent of the root)
+		static constexpr Index NONE = std::numeric_limits<Index>::max();
+
+
+		NodeStore() : table(MINIMUM_TABLE_SIZE, NONE), tableBits(MINIMUM_TABLE_BITS) {}
+
+		size_t size() const { return parents.size(); }
+
+		//Returns the node at the given index
+		Node operator[](Index i) const { return Form::load(stored(i)); }
+
+		//Stores the given node (without a parent) unless already present,
+		//returning its index and whether it was newly inserted
+		std::pair<Index, bool> insert(const Node &node)
+		{
+			const Stored &n = Form::store(node);
+			size_t slot = home(n);
+			for (; table[slot] != NONE; slot = (slot + 1) & (table.size() - 1))
+				if (stored(table[slot]) == n)
+					return { table[slot], false };
+
+			Index i = Index(size());
+			if (chunks.empty() || chunks.back().size() == CHUNK_SIZE)
+			{
+				chunks.emplace_back();
+				chunks.back().reserve(CHUNK_SIZE);
+			}
+			chunks.back().push_back(n);
+			parents.push_back(NONE);
+			operations.push_back(0);
+
+			table[slot] = i;
+			if (size() * 2 > table.size())
+				grow();
+
+			return { i, true };
+		}
+
+		//Records the parent of a node and the operation leading from it
+		void link(Index i, Index parent, Operation op)
+		{
+			parents[i] = parent;
+			operations[i] = op;
+		}
+
+		//Returns the operations leading from the root to the given node
+		Path path(Index i) const
+		{
+			Path p;
+			for (; parents[i] != NONE; i = parents[i])
+				p.push_back(operations[i]);
+
+			std::reverse(p.begin(), p.end());
+			return p;
+		}
+
+	private:
+		//Nodes per chunk of the arena
+		static constexpr size_t CHUNK_BITS = 16;
+		static constexpr size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+
+		//Initial number of table slots
+		static constexpr size_t MINIMUM_TABLE_BITS = 10;
+		static constexpr size_t MINIMUM_TABLE_SIZE = size_t(1) << MINIMUM_TABLE_BITS;
+
+		//Arena of nodes, each chunk reserved up front so its nodes never move
+		std::vector<std::vector<Stored>> chunks;
+
+		//Parent index and operation of each node
+		std::vector<Index> parents;
+		std::vector<Operation> operations;
+
+		//Open addressing table of node indices (NONE if empty), kept at most half full
+		std::vector<Index> table;
+		size_t tableBits;
+
+
+		//Returns the node at the given index, as kept
+		const Stored& stored(Index i) const { return chunks[i >> CHUNK_BITS][i & (CHUNK_SIZE - 1)]; }
+
+		//Returns the first table slot to probe for the given node
+		size_t home(const Stored &n) const
+		{
+			//Fibonacci hashing spreads the node hash over the top bits
+			uint64_t h = uint64_t(std::hash<Stored>()(n)) * 0x9E3779B97F4A7C15ull;
+			return size_t(h >> (64 - tableBits));
+		}
+
+		//Doubles the table, reinserting every index
+		void grow()
+		{
+			tableBits++;
+			table.assign(size_t(1) << tableBits, NONE);
+
+			for (Index i = 0; i < size(); i++)
+			{
+				size_t slot = home(stored(i));
+				while (table[slot] != NONE)
+					slot = (slot + 1) & (table.size() - 1);
+				table[slot] = i;
+			}
+		}
+	};
+}
+
+#endif
@@ -15,73 +15,66 @@ namespace Search
 	template <typename Node>
 	Path PHS(const Node &start, const Node &goal, HeuristicFunc<Node> h)
 	{
-		//Priority queue of nodes to be expanded
-		std::priority_queue<Node, std::vector<Node>, std::function<bool(const Node&, const Node&)>> open
-		(
-			[&](const Node &a, const Node &b) { return h(a, goal) > h(b, goal); }
-		);
-		open.push(start);
+		return PHS(start, goal, FixedGoalHeuristic<Node>{ h, goal });
+	}
 
-		//Set of nodes already visited
-		std::unordered_set<Node> closed;
+	template <typename Node, typename Heuristic, typename Store>
+	Path PHS(const Node &start, const Node &goal, const Heuristic &h)
+	{
+		using Index = typename Store::Index;
 
-		//Map of node to its parent edge
-		std::unordered_map<Node, Edge<Node>> trace;
+		//Stored node reached along an edge, at some depth
+		struct PNode
+		{
+			Index node, parent;
+			Operation op;
+			uint32_t depth;
+		};
 
-		//Pointer to solution node, once found
-		const Node *solution = nullptr;
+		//Every node generated so far, each linked to its parent once expanded
+		Store store;
 
-		//Only start searching if the goal isn't already reached
-		bool found = false;
-		if (start == goal)
-		{
-			solution = &goal;
-			found = true;
-		}
+		//Set of nodes already expanded, by index
+		std::vector<bool> closed;
+
+		//Queue of nodes to be expanded, keyed by (whole) heuristic and
+		//preferring shallower nodes, so each heuristic is taken once
+		BucketQueue<PNode, false> open;
+		open.push({ store.insert(start).first, Store::NONE, 0, 0 }, wholeCost(h(start)), 0);
 
-		while (!found && !open.empty())
+		while (!open.empty())
 		{
-			//DEBUG - Print open queue
-			DEBUG( printCollection(open); )
+			//DEBUG - Print open queue size
+			DEBUG( std::cout << open.size() << " open" << std::endl; )
 
-			//Check for solution
-			if (open.top() == goal)
-			{
-				solution = &open.top();
-				found = true;
-			}
-			else
-			{
-				//Get the next node to expand
-				Node n = open.top();
-				open.pop();
-				closed.insert(n);
+			//Get the next node to expand, skipping those already expanded
+			PNode n = open.top();
+			open.pop();
+			if (n.node < closed.size() && closed[n.node])
+				continue;
 
-				//Get the node's children
-				for (const Edge<Node> &c : n.expand())
-				{
-					//Only keep new children
-					if (closed.find(c.first) == closed.end() && !found)
-					{
-						open.push(c.first);
+			//Close it along the edge it was reached by
+			closed.resize(store.size());
+			closed[n.node] = true;
+			if (n.parent != Store::NONE)
+				store.link(n.node, n.parent, n.op);
 
-						//Log the parent edge
-						trace.insert({ c.first, { n, c.second } });
-					}
-				}
-			}
-		}
+			//Check for solution
+			Node x = store[n.node];
+			if (x == goal)
+				return store.path(n.node);
 
-		//Construct solution path
-		Path path;
-		while (trace.find(*solution) != trace.end())
-		{
-			path.push_back(trace.at(*solution).second);
-			solution = &trace.at(*solution).first;
+			//Get the node's children
+			x.expand([&](const Node &c, Operation op)
+			{
+				//Only keep children not yet expanded
+				Index i = store.insert(c).first;
+				if (i >= closed.size() || !closed[i])
+					open.push({ i, n.node, op, n.depth + 1 }, wholeCost(h(c)), n.depth + 1);
+			});
 		}
 
-		std::reverse(path.begin(), path.end());
-		return path;
+		return Path();
 	}
 }
 
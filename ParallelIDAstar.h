@@ -0,0 +1,282 @@
+/**
+ * ParallelIDAstar.h
+ * Implements IDA* search across multiple threads. Each
+ * iteration is split into the subtrees below every path
+ * of a given depth, which are shared out through per-thread
+ * work-stealing queues, and searched by a pool of threads
+ * kept alive across iterations. Node types must meet the
+ * same requirements as for PrunedIDAstar.
+ *
+ * @author Sam Griffiths
+ */
+
+#ifndef ParallelIDAstar_H
+#define ParallelIDAstar_H
+
+#include "Search.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace Search
+{
+	//Subtree roots of one ParallelIDAstar iteration
+	template <typename Node, typename Heuristic>
+	struct ParallelIDAstarSplit
+	{
+		using Tracker = HeuristicTracker<Node, Heuristic>;
+
+		const Node &goal;
+		Tracker tracker;
+		size_t threshold, thresholdNew, splitDepth;
+
+		//Operations leading to each subtree root, and the roots themselves with their heuristic tracks
+		std::vector<Path> prefixes;
+		std::vector<Node> roots;
+		std::vector<typename Tracker::Track> rootTracks;
+
+		//Set if the goal lies above the split depth
+		bool found;
+		Path solution;
+
+
+		ParallelIDAstarSplit(const Node &goal, const Heuristic &h, size_t threshold, size_t splitDepth)
+			: goal(goal), tracker{ h }, threshold(threshold), thresholdNew(std::numeric_limits<size_t>::max()),
+			splitDepth(splitDepth), found(false) {}
+
+		//Collects the roots below the given node, pruning as PrunedIDAstar would
+		void collect(const Node &n, const typename Tracker::Track &track, Path &prefix)
+		{
+			if (found)
+				return;
+
+			//Check for solution
+			if (n == goal)
+			{
+				solution = prefix;
+				found = true;
+				return;
+			}
+
+			if (prefix.size() == splitDepth)
+			{
+				prefixes.push_back(prefix);
+				roots.push_back(n);
+				rootTracks.push_back(track);
+				return;
+			}
+
+			for (Operation op = 0; op < Node::OPERATIONS; op++)
+			{
+				if (!prefix.empty() && Node::redundant(prefix.back(), op))
+					continue;
+
+				Node c = n.apply(op);
+				typename Tracker::Track t = tracker.track(track, c, op);
+				size_t cost = prefix.size() + 1 + tracker.cost(t);
+
+				//If above the threshold, prune and log minimum
+				if (cost > threshold)
+				{
+					if (cost < thresholdNew)
+						thresholdNew = cost;
+					continue;
+				}
+
+				prefix.push_back(op);
+				collect(c, t, prefix);
+				prefix.pop_back();
+			}
+		}
+	};
+
+	//Per-thread queue of subtree indices, stolen from at the back
+	struct WorkStealingQueue
+	{
+		std::mutex mutex;
+		std::deque<size_t> tasks;
+	};
+
+	/* Threads kept waiting between iterations, so that each is not paid
+		for in thread creation. The calling thread takes part as id 0. */
+	class IterationPool
+	{
+	public:
+		IterationPool(size_t threads) : task(nullptr), generation(0), running(0), stopping(false)
+		{
+			for (size_t id = 1; id < threads; id++)
+				workers.emplace_back([this, id]() { work(id); });
+		}
+
+		~IterationPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			wake.notify_all();
+
+			for (std::thread &t : workers)
+				t.join();
+		}
+
+		//Runs the given task on every thread, by id, returning once all have finished
+		void run(const std::function<void(size_t)> &f)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				task = &f;
+				running = workers.size();
+				generation++;
+			}
+			wake.notify_all();
+
+			f(0);
+
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [this]() { return running == 0; });
+		}
+
+	private:
+		std::vector<std::thread> workers;
+
+		std::mutex mutex;
+		std::condition_variable wake, done;
+
+		//Task of the current run, the number of runs so far, and the workers yet to finish this one
+		const std::function<void(size_t)> *task;
+		size_t generation, running;
+		bool stopping;
+
+		//Runs each task given, until stopped
+		void work(size_t id)
+		{
+			size_t seen = 0;
+			std::unique_lock<std::mutex> lock(mutex);
+
+			while (true)
+			{
+				wake.wait(lock, [&]() { return stopping || generation != seen; });
+				if (stopping)
+					return;
+
+				seen = generation;
+				const std::function<void(size_t)> &f = *task;
+				lock.unlock();
+				f(id);
+				lock.lock();
+
+				if (--running == 0)
+					done.notify_one();
+			}
+		}
+	};
+
+	template <typename Node>
+	Path ParallelIDAstar(const Node &start, const Node &goal, HeuristicFunc<Node> h, size_t threads, size_t splitDepth)
+	{
+		return ParallelIDAstar(start, goal, FixedGoalHeuristic<Node>{ h, goal }, threads, splitDepth);
+	}
+
+	template <typename Node, typename Heuristic>
+	Path ParallelIDAstar(const Node &start, const Node &goal, const Heuristic &h, size_t threads, size_t splitDepth)
+	{
+		if (threads == 0)
+			threads = 1;
+
+		HeuristicTracker<Node, Heuristic> tracker{ h };
+		typename HeuristicTracker<Node, Heuristic>::Track startTrack = tracker.track(start);
+		size_t threshold = tracker.cost(startTrack);
+
+		IterationPool pool(threads);
+
+		while (true)
+		{
+			//Split the iteration into subtrees
+			ParallelIDAstarSplit<Node, Heuristic> split(goal, h, threshold, splitDepth);
+			Path prefix;
+			split.collect(start, startTrack, prefix);
+
+			if (split.found)
+				return split.solution;
+
+			//Deal the subtrees out round-robin
+			std::vector<WorkStealingQueue> queues(threads);
+			for (size_t i = 0; i < split.roots.size(); i++)
+				queues[i % threads].tasks.push_back(i);
+
+			//Shared solution state
+			std::atomic<bool> found(false);
+			std::mutex solutionMutex;
+			Path solution;
+
+			//Minimum pruned cost seen by each worker
+			std::vector<size_t> thresholdsNew(threads, split.thresholdNew);
+
+			std::function<void(size_t)> worker = [&](size_t id)
+			{
+				PrunedIDAstarWalk<Node, Heuristic> walk(goal, h);
+				walk.threshold = threshold;
+				walk.thresholdNew = split.thresholdNew;
+				walk.cancel = &found;
+
+				while (!found.load(std::memory_order_relaxed))
+				{
+					//Take from the front of our own queue, else steal from the back of another
+					size_t task = split.roots.size();
+					for (size_t i = 0; i < threads && task == split.roots.size(); i++)
+					{
+						WorkStealingQueue &q = queues[(id + i) % threads];
+						std::lock_guard<std::mutex> lock(q.mutex);
+						if (!q.tasks.empty())
+						{
+							if (i == 0)
+							{
+								task = q.tasks.front();
+								q.tasks.pop_front();
+							}
+							else
+							{
+								task = q.tasks.back();
+								q.tasks.pop_back();
+							}
+						}
+					}
+
+					//No work left anywhere
+					if (task == split.roots.size())
+						break;
+
+					//Search the subtree below its prefix
+					const Path &p = split.prefixes[task];
+					walk.reset(split.roots[task], split.rootTracks[task]);
+					std::copy(p.begin(), p.end(), walk.path.begin());
+
+					if (walk.search(p.size(), p.empty() ? 0 : p.back()) && !found.exchange(true))
+					{
+						std::lock_guard<std::mutex> lock(solutionMutex);
+						solution = walk.path;
+					}
+				}
+
+				thresholdsNew[id] = walk.thresholdNew;
+			};
+
+			pool.run(worker);
+
+			if (found)
+				return solution;
+
+			//Update threshold for next iteration, unless nothing was pruned
+			size_t thresholdNew = *std::min_element(thresholdsNew.begin(), thresholdsNew.end());
+			if (thresholdNew == std::numeric_limits<size_t>::max())
+				return Path();
+
+			threshold = thresholdNew;
+		}
+	}
+}
+
+#endif
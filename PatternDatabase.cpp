@@ -0,0 +1,429 @@
+/**
+ * PatternDatabase.cpp
+ * Implements the PatternDatabase class, a read-only table
+ * of 4-bit heuristic values packed in pairs.
+ *
+ * @author Sam Griffiths
+ */
+
+#include "PatternDatabase.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+	#ifdef __linux__
+		#include <sys/syscall.h>
+	#endif
+#endif
+
+namespace
+{
+	//Size of a huge page, to which placed regions are rounded and aligned
+	const size_t HUGE_PAGE = size_t(2) << 20;
+
+	//Ids of the online NUMA nodes, which need not be numbered contiguously (node 0 alone if unknown)
+	std::vector<int> numaNodes()
+	{
+		std::vector<int> nodes;
+
+#ifdef _WIN32
+		//Numbers up to the highest may name no node, which then has no processors
+		ULONG highest = 0;
+		if (GetNumaHighestNodeNumber(&highest))
+			for (USHORT node = 0; node <= highest; node++)
+			{
+				GROUP_AFFINITY affinity;
+				if (GetNumaNodeProcessorMaskEx(node, &affinity) && affinity.Mask != 0)
+					nodes.push_back(int(node));
+			}
+#else
+		//Listed as comma-separated ids and ranges, e.g. "0,2-3"
+		std::ifstream online("/sys/devices/system/node/online");
+		std::string range;
+		while (std::getline(online, range, ','))
+		{
+			size_t dash = range.find('-');
+			try
+			{
+				int first = std::stoi(range.substr(0, dash));
+				int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+				for (int node = first; node <= last; node++)
+					nodes.push_back(node);
+			}
+			catch (std::exception&) {
+				nodes.clear();
+				break;
+			}
+		}
+#endif
+
+		if (nodes.empty())
+			nodes.push_back(0);
+		return nodes;
+	}
+
+	//Names pages of the given size, e.g. "2 MB pages", or just "huge pages" if unknown
+	std::string pageName(size_t size)
+	{
+		const char *units[] = { "B", "KB", "MB", "GB" };
+		size_t unit = 0;
+		for (; unit < 3 && size >= 1024 && size % 1024 == 0; unit++)
+			size /= 1024;
+		return size == 0 ? "huge pages" : std::to_string(size) + " " + units[unit] + " pages";
+	}
+
+#ifndef _WIN32
+	//Size of the explicit huge pages, as listed in /proc/meminfo (in KB); 0 if unknown
+	size_t explicitHugePageSize()
+	{
+		std::ifstream meminfo("/proc/meminfo");
+		std::string line;
+		while (std::getline(meminfo, line))
+		{
+			if (line.compare(0, 13, "Hugepagesize:") != 0)
+				continue;
+
+			try { return size_t(std::stoul(line.substr(13))) << 10; }
+			catch (std::exception&) { return 0; }
+		}
+		return 0;
+	}
+
+	//Whether transparent huge pages may be given to regions advised to use them
+	bool transparentHugePages()
+	{
+		std::ifstream enabled("/sys/kernel/mm/transparent_hugepage/enabled");
+		std::string mode;
+		return std::getline(enabled, mode) && mode.find("[never]") == std::string::npos;
+	}
+#endif
+
+	/* Allocates a region of at least the given length (updated to that
+		allocated) on the given NUMA node, or any if negative, preferring
+		huge pages if asked. Names the pages obtained; nullptr if unable. */
+	void* allocateRegion(size_t &length, bool hugePages, int node, std::string &pages)
+	{
+		length = (length + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+
+#ifdef _WIN32
+		DWORD preferred = node < 0 ? NUMA_NO_PREFERRED_NODE : DWORD(node);
+		void *p = nullptr;
+
+		//Large pages need the lock pages in memory privilege, and are often refused
+		size_t large = GetLargePageMinimum();
+		if (hugePages && large > 0)
+		{
+			size_t l = (length + large - 1) / large * large;
+			p = VirtualAllocExNuma(GetCurrentProcess(), nullptr, l, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+				PAGE_READWRITE, preferred);
+			if (p)
+			{
+				length = l;
+				pages = pageName(large);
+				return p;
+			}
+		}
+
+		p = VirtualAllocExNuma(GetCurrentProcess(), nullptr, length, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, preferred);
+		pages = "4 KB pages";
+		return p;
+#else
+		void *p = MAP_FAILED;
+
+		//Explicit huge pages come from the pool reserved in /proc/sys/vm/nr_hugepages
+	#ifdef MAP_HUGETLB
+		if (hugePages)
+		{
+			//Of the default size, which need not be HUGE_PAGE
+			size_t size = explicitHugePageSize();
+			size_t l = size > 0 ? (length + size - 1) / size * size : length;
+			p = mmap(nullptr, l, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (p != MAP_FAILED)
+			{
+				length = l;
+				pages = pageName(size);
+			}
+		}
+	#endif
+
+		//Otherwise ordinary pages, aligned so that the kernel may back them with transparent huge pages
+		if (p == MAP_FAILED)
+		{
+			size_t padded = length + HUGE_PAGE;
+			uint8_t *q = static_cast<uint8_t*>(mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+			if (q == MAP_FAILED)
+				return nullptr;
+
+			size_t head = (HUGE_PAGE - reinterpret_cast<uintptr_t>(q) % HUGE_PAGE) % HUGE_PAGE;
+			if (head > 0)
+				munmap(q, head);
+			munmap(q + head + length, HUGE_PAGE - head);
+
+			p = q + head;
+			pages = "4 KB pages";
+
+	#ifdef MADV_HUGEPAGE
+			if (hugePages && madvise(p, length, MADV_HUGEPAGE) == 0 && transparentHugePages())
+				pages = "transparent huge pages";
+	#endif
+		}
+
+		//Bind the region to the node before it is first touched, which places its pages, else give it up
+	#if defined(__linux__) && defined(SYS_mbind)
+		if (node >= 0)
+		{
+			const int MPOL_BIND = 2;
+			const size_t BITS = sizeof(unsigned long) * 8;
+			std::vector<unsigned long> mask(size_t(node) / BITS + 1);
+			mask[size_t(node) / BITS] = 1ul << (size_t(node) % BITS);
+
+			if (syscall(SYS_mbind, p, length, MPOL_BIND, mask.data(), mask.size() * BITS, 0) != 0)
+			{
+				munmap(p, length);
+				return nullptr;
+			}
+		}
+	#endif
+
+		return p;
+#endif
+	}
+}
+
+PatternDatabase::PatternDatabase()
+	: entries(nullptr), pairs(0), mapping(nullptr), mappingLength(0)
+{
+}
+
+PatternDatabase::PatternDatabase(std::vector<FourBitIntPair> &&entries)
+	: pairs(entries.size()), owned(std::move(entries)), mapping(nullptr), mappingLength(0), placementName("heap memory")
+{
+	this->entries = owned.data();
+}
+
+PatternDatabase PatternDatabase::map(const std::string &path, size_t n, bool populate)
+{
+	PatternDatabase pd;
+	size_t length = n / 2 * sizeof(FourBitIntPair);
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		throw std::ios_base::failure("Cannot open " + path);
+
+	//The view keeps the mapping (and file) open once both handles are closed
+	LARGE_INTEGER fileSize;
+	HANDLE section = nullptr;
+	if (GetFileSizeEx(file, &fileSize) && size_t(fileSize.QuadPart) >= length)
+		section = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+
+	if (section == nullptr)
+		throw std::ios_base::failure("Cannot map " + path);
+
+	void *view = MapViewOfFile(section, FILE_MAP_READ, 0, 0, length);
+	CloseHandle(section);
+
+	if (view == nullptr)
+		throw std::ios_base::failure("Cannot map " + path);
+
+	//Fault in every page now, by touching one byte of each
+	if (populate)
+	{
+		volatile uint8_t sink = 0;
+		for (size_t i = 0; i < length; i += 4096)
+			sink ^= static_cast<const uint8_t*>(view)[i];
+	}
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw std::ios_base::failure("Cannot open " + path);
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || size_t(st.st_size) < length)
+	{
+		close(fd);
+		throw std::ios_base::failure("Cannot map " + path);
+	}
+
+	//Shared, so every process maps the same page cache copy
+	int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+	if (populate)
+		flags |= MAP_POPULATE;
+#endif
+
+	void *view = mmap(nullptr, length, PROT_READ, flags, fd, 0);
+	close(fd);
+
+	if (view == MAP_FAILED)
+		throw std::ios_base::failure("Cannot map " + path);
+
+	//Lookups are scattered, so read ahead only if asked to fault everything in
+	madvise(view, length, populate ? MADV_WILLNEED : MADV_RANDOM);
+#endif
+
+	pd.mapping = view;
+	pd.mappingLength = length;
+	pd.entries = static_cast<const FourBitIntPair*>(view);
+	pd.pairs = n / 2;
+	pd.placementName = "mapped file";
+
+	return pd;
+}
+
+PatternDatabase PatternDatabase::place(bool hugePages, bool replicate) const
+{
+	PatternDatabase pd;
+	size_t length = pairs * sizeof(FourBitIntPair);
+	std::vector<int> nodes = replicate ? numaNodes() : std::vector<int>();
+	std::vector<int> placed;
+	std::string pages;
+
+	//A copy bound to each node, skipping any the region cannot be bound to
+	if (nodes.size() > 1)
+	{
+		for (int node : nodes)
+		{
+			size_t l = length;
+			void *p = allocateRegion(l, hugePages, node, pages);
+			if (p == nullptr)
+				continue;
+
+			std::memcpy(p, entries, length);
+			pd.regions.push_back({ p, l });
+			placed.push_back(node);
+		}
+	}
+
+	//Otherwise one copy, on any node
+	if (pd.regions.size() <= 1)
+	{
+		pd.release();
+		placed.clear();
+
+		size_t l = length;
+		void *p = allocateRegion(l, hugePages, -1, pages);
+		if (p == nullptr)
+			throw std::bad_alloc();
+
+		std::memcpy(p, entries, length);
+		pd.regions.push_back({ p, l });
+	}
+
+	pd.entries = static_cast<const FourBitIntPair*>(pd.regions.front().first);
+	pd.pairs = pairs;
+	pd.placementName = pages;
+
+	//Threads on a node without a copy read the first
+	if (!placed.empty())
+	{
+		pd.nodeReplicas.assign(size_t(*std::max_element(placed.begin(), placed.end())) + 1, 0);
+		for (size_t i = 0; i < placed.size(); i++)
+		{
+			pd.replicas.push_back(static_cast<const FourBitIntPair*>(pd.regions[i].first));
+			pd.nodeReplicas[size_t(placed[i])] = i;
+		}
+
+		pd.placementName += " on " + std::to_string(placed.size()) + " NUMA nodes";
+		if (placed.size() < nodes.size())
+			pd.placementName += " (of " + std::to_string(nodes.size()) + ")";
+	}
+
+	return pd;
+}
+
+int PatternDatabase::currentNode()
+{
+#ifdef _WIN32
+	PROCESSOR_NUMBER processor;
+	USHORT node = 0;
+	GetCurrentProcessorNumberEx(&processor);
+	return GetNumaProcessorNodeEx(&processor, &node) ? int(node) : 0;
+#elif defined(__linux__) && defined(SYS_getcpu)
+	unsigned cpu = 0, node = 0;
+	return (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) ? int(node) : 0;
+#else
+	return 0;
+#endif
+}
+
+PatternDatabase::PatternDatabase(PatternDatabase &&other)
+	: PatternDatabase()
+{
+	*this = std::move(other);
+}
+
+PatternDatabase& PatternDatabase::operator=(PatternDatabase &&other)
+{
+	if (this != &other)
+	{
+		release();
+
+		owned = std::move(other.owned);
+		entries = (other.mapping || !other.regions.empty()) ? other.entries : owned.data();
+		pairs = other.pairs;
+		mapping = other.mapping;
+		mappingLength = other.mappingLength;
+		regions = std::move(other.regions);
+		replicas = std::move(other.replicas);
+		nodeReplicas = std::move(other.nodeReplicas);
+		placementName = std::move(other.placementName);
+
+		other.entries = nullptr;
+		other.pairs = 0;
+		other.mapping = nullptr;
+		other.mappingLength = 0;
+		other.regions.clear();
+		other.replicas.clear();
+		other.nodeReplicas.clear();
+	}
+
+	return *this;
+}
+
+PatternDatabase::~PatternDatabase()
+{
+	release();
+}
+
+void PatternDatabase::release()
+{
+	if (mapping)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(mapping);
+#else
+		munmap(mapping, mappingLength);
+#endif
+	}
+
+	for (const std::pair<void*, size_t> &r : regions)
+	{
+#ifdef _WIN32
+		VirtualFree(r.first, 0, MEM_RELEASE);
+#else
+		munmap(r.first, r.second);
+#endif
+	}
+
+	mapping = nullptr;
+	mappingLength = 0;
+	regions.clear();
+	replicas.clear();
+	nodeReplicas.clear();
+}
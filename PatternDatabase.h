@@ -0,0 +1,121 @@
+/**
+ * PatternDatabase.h
+ * Declares the PatternDatabase class, a read-only table of
+ * 4-bit heuristic values packed in pairs. The entries are
+ * either held in memory or mapped straight from a file, so
+ * that processes solving at once share one copy of them.
+ * They may also be placed on huge pages, to spare random
+ * lookups most TLB misses, and copied to every NUMA node,
+ * so that each thread reads the copy local to it.
+ *
+ * @author Sam Griffiths
+ */
+
+#pragma once
+
+#include "FourBitIntPair.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <xmmintrin.h>
+#endif
+
+class PatternDatabase
+{
+public:
+	//Default constructor gives an empty database
+	PatternDatabase();
+
+	//Takes ownership of the given entries
+	explicit PatternDatabase(std::vector<FourBitIntPair> &&entries);
+
+	//Maps the given file of n 4-bit values read-only, optionally
+	//faulting it all in now (throws std::ios_base::failure if unable)
+	static PatternDatabase map(const std::string &path, size_t n, bool populate = true);
+
+	/* Returns a copy of the entries, optionally on huge pages (explicit
+		huge pages if the system has them reserved, else transparent ones)
+		and optionally replicated on every NUMA node. Each falls back to
+		ordinary pages, or a single copy, where unavailable. */
+	PatternDatabase place(bool hugePages, bool replicate) const;
+
+	//Describes how the entries are held, e.g. "2 MB pages on 2 NUMA nodes"
+	const std::string& placement() const { return placementName; }
+
+	PatternDatabase(PatternDatabase &&other);
+	PatternDatabase& operator=(PatternDatabase &&other);
+	~PatternDatabase();
+
+	//Returns the given pair of values
+	const FourBitIntPair& operator[](size_t i) const { return local()[i]; }
+
+	//Hints that the given pair of values is about to be read, so that
+	//the cache line can be fetched while other work goes on
+	void prefetch(size_t i) const
+	{
+	#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		_mm_prefetch(reinterpret_cast<const char*>(local() + i), _MM_HINT_T0);
+	#elif defined(__GNUC__)
+		__builtin_prefetch(local() + i);
+	#endif
+	}
+
+	//Number of pairs of values
+	size_t size() const { return pairs; }
+
+	//Returns the packed pairs, for writing out
+	const FourBitIntPair* data() const { return entries; }
+
+private:
+	const FourBitIntPair *entries;
+	size_t pairs;
+
+	//Backing store, if held in memory
+	std::vector<FourBitIntPair> owned;
+
+	//Backing store, if mapped (with its length in bytes)
+	void *mapping;
+	size_t mappingLength;
+
+	//Backing stores, if placed (one per NUMA node if replicated), with their lengths in bytes
+	std::vector<std::pair<void*, size_t>> regions;
+	std::string placementName;
+
+	//Entries on each NUMA node holding a copy, if replicated, and the copy
+	//each NUMA node reads by its id (the first, if it holds none)
+	std::vector<const FourBitIntPair*> replicas;
+	std::vector<size_t> nodeReplicas;
+
+	//Lookups a thread makes in replicated databases between queries of its NUMA node: the
+	//scheduler may move it to another node, but each query costs a system call
+	static const uint32_t NODE_QUERY_PERIOD = 4096;
+
+	//NUMA node of each thread, and the lookups it has left before querying it again
+	static inline thread_local int threadNode = 0;
+	static inline thread_local uint32_t threadLookupsLeft = 0;
+
+	//Returns the entries local to the calling thread
+	const FourBitIntPair* local() const
+	{
+		if (replicas.empty())
+			return entries;
+
+		if (threadLookupsLeft-- == 0)
+		{
+			threadNode = currentNode();
+			threadLookupsLeft = NODE_QUERY_PERIOD - 1;
+		}
+
+		size_t node = size_t(threadNode);
+		return replicas[node < nodeReplicas.size() ? nodeReplicas[node] : 0];
+	}
+
+	//Returns the NUMA node the calling thread is running on
+	static int currentNode();
+
+	//Unmaps the backing stores, if mapped or placed
+	void release();
+};
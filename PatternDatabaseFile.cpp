@@ -0,0 +1,479 @@
+/**
+ * PatternDatabaseFile.cpp
+ * Implements reading and writing of the pattern database
+ * container file.
+ *
+ * All fields are little-endian. The file begins with the
+ * magic "EDNAPDB\0", the version, and the length and CRC-32
+ * of the header that follows, which is checked before any
+ * count within it is trusted. The header holds the number
+ * of tables; each table then gives its description
+ * (length-prefixed), ranking scheme, number of values, block
+ * size and number of blocks, followed by each block's codec,
+ * stored length and CRC-32 of its decoded bytes. The blocks
+ * themselves follow, table by table.
+ *
+ * A compressed block is a canonical Huffman code over the
+ * 4-bit values (high nibble first): 16 code lengths, then
+ * the codes packed most significant bit first.
+ *
+ * @author Sam Griffiths
+ */
+
+#include "PatternDatabaseFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+	const char MAGIC[8] = { 'E', 'D', 'N', 'A', 'P', 'D', 'B', 0 };
+
+	//Decoded bytes per block
+	const uint32_t BLOCK_BYTES = 1 << 20;
+
+	//Most tables, largest header and largest decoded block accepted from a file
+	const uint64_t MAX_TABLES = 64;
+	const uint64_t MAX_HEADER_BYTES = 1 << 24;
+	const uint64_t MAX_BLOCK_BYTES = 1 << 24;
+
+	//Bytes in the index entry of each block
+	const uint64_t BLOCK_INFO_BYTES = 9;
+
+	//How each block is stored
+	enum Codec : uint8_t { RAW = 0, HUFFMAN = 1 };
+
+	//Longest Huffman code possible over 16 symbols
+	const unsigned MAX_CODE_LENGTH = 15;
+
+	struct BlockInfo
+	{
+		uint8_t codec;
+		uint32_t length, crc;
+	};
+
+
+	void writeWord(std::ostream &os, uint64_t x, size_t bytes)
+	{
+		for (size_t i = 0; i < bytes; i++)
+			os.put(char(x >> (8 * i)));
+	}
+
+	uint64_t readWord(std::istream &is, size_t bytes)
+	{
+		uint64_t x = 0;
+		for (size_t i = 0; i < bytes; i++)
+		{
+			int c = is.get();
+			if (c == EOF)
+				throw std::ios_base::failure("Pattern database file truncated");
+			x |= uint64_t(uint8_t(c)) << (8 * i);
+		}
+		return x;
+	}
+
+	//Returns the number of bytes left in the stream, or the largest size if it cannot tell
+	uint64_t remaining(std::istream &is)
+	{
+		std::istream::pos_type here = is.tellg();
+		if (here == std::istream::pos_type(-1) || !is.seekg(0, std::ios_base::end))
+		{
+			is.clear();
+			return std::numeric_limits<uint64_t>::max();
+		}
+
+		std::istream::pos_type end = is.tellg();
+		is.seekg(here);
+		return uint64_t(end - here);
+	}
+
+	//CRC-32 (as used by zip) of the given bytes
+	uint32_t crc32(const uint8_t *data, size_t length)
+	{
+		static const std::vector<uint32_t> table = []
+		{
+			std::vector<uint32_t> t(256);
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t c = i;
+				for (int k = 0; k < 8; k++)
+					c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+				t[i] = c;
+			}
+			return t;
+		}();
+
+		uint32_t c = 0xFFFFFFFF;
+		for (size_t i = 0; i < length; i++)
+			c = table[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+		return c ^ 0xFFFFFFFF;
+	}
+
+	//Assigns canonical codes to symbols of the given code lengths (zero if unused)
+	void canonicalCodes(const uint8_t lengths[16], uint16_t codes[16])
+	{
+		uint16_t code = 0;
+		for (unsigned length = 1; length <= MAX_CODE_LENGTH; length++, code <<= 1)
+			for (unsigned s = 0; s < 16; s++)
+				if (lengths[s] == length)
+					codes[s] = code++;
+	}
+
+	//Huffman codes the 4-bit values of the given bytes, or returns an empty
+	//result if that would be no smaller
+	std::vector<uint8_t> compressBlock(const uint8_t *data, size_t length)
+	{
+		size_t frequency[16] = { 0 };
+		for (size_t i = 0; i < length; i++)
+		{
+			frequency[data[i] >> 4]++;
+			frequency[data[i] & 15]++;
+		}
+
+		//Build the Huffman tree bottom up, noting each node's parent
+		using Weight = std::pair<size_t, unsigned>;
+		std::priority_queue<Weight, std::vector<Weight>, std::greater<Weight>> open;
+		unsigned parent[31];
+		unsigned nodes = 16;
+
+		for (unsigned s = 0; s < 16; s++)
+			if (frequency[s] > 0)
+				open.push({ frequency[s], s });
+
+		while (open.size() > 1)
+		{
+			Weight a = open.top(); open.pop();
+			Weight b = open.top(); open.pop();
+			parent[a.second] = parent[b.second] = nodes;
+			open.push({ a.first + b.first, nodes++ });
+		}
+
+		//Code length is the leaf's depth (at least 1, for a lone symbol)
+		unsigned root = open.empty() ? 0 : open.top().second;
+		uint8_t lengths[16] = { 0 };
+		for (unsigned s = 0; s < 16; s++)
+			if (frequency[s] > 0)
+			{
+				uint8_t depth = 0;
+				for (unsigned x = s; x != root; x = parent[x])
+					depth++;
+				lengths[s] = std::max<uint8_t>(depth, 1);
+			}
+
+		uint16_t codes[16];
+		canonicalCodes(lengths, codes);
+
+		std::vector<uint8_t> out(lengths, lengths + 16);
+		out.reserve(length);
+
+		//Pack codes most significant bit first
+		uint64_t buffer = 0;
+		unsigned bits = 0;
+		auto put = [&](unsigned s)
+		{
+			buffer = buffer << lengths[s] | codes[s];
+			bits += lengths[s];
+			while (bits >= 8)
+			{
+				bits -= 8;
+				out.push_back(uint8_t(buffer >> bits));
+			}
+		};
+
+		for (size_t i = 0; i < length; i++)
+		{
+			put(data[i] >> 4);
+			put(data[i] & 15);
+
+			if (out.size() >= length)
+				return std::vector<uint8_t>();
+		}
+
+		if (bits > 0)
+			out.push_back(uint8_t(buffer << (8 - bits)));
+
+		return out.size() < length ? out : std::vector<uint8_t>();
+	}
+
+	//Decodes a Huffman coded block into the given number of bytes, returning false if malformed
+	bool decompressBlock(const uint8_t *in, size_t inLength, uint8_t *out, size_t outLength)
+	{
+		if (inLength < 16)
+			return false;
+
+		uint8_t lengths[16];
+		uint16_t codes[16];
+		std::memcpy(lengths, in, 16);
+		//The codes must fit within 15 bits without overlapping (Kraft's inequality)
+		size_t space = 0;
+		for (uint8_t l : lengths)
+		{
+			if (l > MAX_CODE_LENGTH)
+				return false;
+			if (l > 0)
+				space += size_t(1) << (MAX_CODE_LENGTH - l);
+		}
+		if (space > size_t(1) << MAX_CODE_LENGTH)
+			return false;
+		canonicalCodes(lengths, codes);
+
+		//Every 15-bit window maps to the symbol its leading code gives
+		std::vector<uint8_t> symbol(size_t(1) << MAX_CODE_LENGTH, 16), length(size_t(1) << MAX_CODE_LENGTH);
+		for (unsigned s = 0; s < 16; s++)
+			if (lengths[s] > 0)
+			{
+				unsigned shift = MAX_CODE_LENGTH - lengths[s];
+				for (size_t w = size_t(codes[s]) << shift; w < size_t(codes[s] + 1) << shift; w++)
+				{
+					symbol[w] = uint8_t(s);
+					length[w] = lengths[s];
+				}
+			}
+
+		const uint8_t *p = in + 16, *end = in + inLength;
+		uint64_t buffer = 0;
+		unsigned bits = 0;
+
+		auto get = [&]() -> unsigned
+		{
+			//Refill, padding with zeroes beyond the end
+			while (bits <= 56)
+			{
+				buffer |= uint64_t(p < end ? *p : 0) << (56 - bits);
+				p++;
+				bits += 8;
+			}
+
+			unsigned w = unsigned(buffer >> (64 - MAX_CODE_LENGTH));
+			buffer <<= length[w];
+			bits -= length[w];
+			return symbol[w];
+		};
+
+		for (size_t i = 0; i < outLength; i++)
+		{
+			unsigned a = get(), b = get();
+			if (a > 15 || b > 15)
+				return false;
+			out[i] = uint8_t(a << 4 | b);
+		}
+
+		//Fail if the codes overran the block
+		return size_t(p - in) <= inLength + 8;
+	}
+
+	//Calls f(i) for each i below n, shared dynamically between the given number of threads
+	template <typename F>
+	void parallelFor(size_t n, size_t threads, F f)
+	{
+		std::atomic<size_t> next(0);
+		auto worker = [&]()
+		{
+			for (size_t i; (i = next.fetch_add(1)) < n;)
+				f(i);
+		};
+
+		std::vector<std::thread> pool;
+		for (size_t i = 1; i < std::min(threads, n); i++)
+			pool.emplace_back(worker);
+		worker();
+		for (std::thread &t : pool)
+			t.join();
+	}
+}
+
+namespace PatternDatabaseFile
+{
+	void write(std::ostream &os, const std::vector<Table> &tables, bool compress, size_t threads)
+	{
+		os.write(MAGIC, sizeof(MAGIC));
+		writeWord(os, VERSION, 4);
+
+		//Encode every block of every table up front
+		std::vector<std::vector<BlockInfo>> info(tables.size());
+		std::vector<std::vector<std::vector<uint8_t>>> encoded(tables.size());
+
+		for (size_t t = 0; t < tables.size(); t++)
+		{
+			const uint8_t *data = reinterpret_cast<const uint8_t*>(tables[t].pd.data());
+			size_t bytes = tables[t].pd.size() * sizeof(FourBitIntPair);
+			size_t blocks = (bytes + BLOCK_BYTES - 1) / BLOCK_BYTES;
+
+			info[t].resize(blocks);
+			encoded[t].resize(blocks);
+
+			parallelFor(blocks, threads, [&](size_t b)
+			{
+				const uint8_t *block = data + b * BLOCK_BYTES;
+				size_t length = std::min<size_t>(BLOCK_BYTES, bytes - b * BLOCK_BYTES);
+
+				if (compress)
+					encoded[t][b] = compressBlock(block, length);
+
+				BlockInfo &i = info[t][b];
+				i.codec = encoded[t][b].empty() ? RAW : HUFFMAN;
+				i.length = uint32_t(encoded[t][b].empty() ? length : encoded[t][b].size());
+				i.crc = crc32(block, length);
+			});
+		}
+
+		//Table headers and block indices, gathered to be checksummed
+		std::ostringstream header;
+		writeWord(header, tables.size(), 4);
+		for (size_t t = 0; t < tables.size(); t++)
+		{
+			writeWord(header, tables[t].description.size(), 4);
+			header.write(tables[t].description.data(), tables[t].description.size());
+			writeWord(header, tables[t].ranking, 4);
+			writeWord(header, tables[t].n, 8);
+			writeWord(header, BLOCK_BYTES, 4);
+			writeWord(header, info[t].size(), 4);
+
+			for (const BlockInfo &i : info[t])
+			{
+				writeWord(header, i.codec, 1);
+				writeWord(header, i.length, 4);
+				writeWord(header, i.crc, 4);
+			}
+		}
+
+		std::string headerBytes = header.str();
+		writeWord(os, headerBytes.size(), 4);
+		writeWord(os, crc32(reinterpret_cast<const uint8_t*>(headerBytes.data()), headerBytes.size()), 4);
+		os.write(headerBytes.data(), headerBytes.size());
+
+		//Block contents
+		for (size_t t = 0; t < tables.size(); t++)
+		{
+			const char *data = reinterpret_cast<const char*>(tables[t].pd.data());
+			for (size_t b = 0; b < info[t].size(); b++)
+			{
+				if (info[t][b].codec == RAW)
+					os.write(data + b * BLOCK_BYTES, info[t][b].length);
+				else
+					os.write(reinterpret_cast<const char*>(encoded[t][b].data()), encoded[t][b].size());
+			}
+		}
+	}
+
+	std::vector<Table> read(std::istream &is, size_t threads)
+	{
+		char magic[sizeof(MAGIC)];
+		if (!is.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+			throw std::ios_base::failure("Not a pattern database file");
+
+		if (readWord(is, 4) != VERSION)
+			throw std::ios_base::failure("Unsupported pattern database file version");
+
+		//The header must lie within the file and match its checksum before any count in it is used
+		uint64_t headerLength = readWord(is, 4), headerCrc = readWord(is, 4);
+		uint64_t fileBytes = remaining(is);
+		if (headerLength > MAX_HEADER_BYTES)
+			throw std::ios_base::failure("Pattern database file header corrupt");
+		if (headerLength > fileBytes)
+			throw std::ios_base::failure("Pattern database file truncated");
+
+		std::string headerBytes(size_t(headerLength), '\0');
+		if (!is.read(&headerBytes[0], headerBytes.size()))
+			throw std::ios_base::failure("Pattern database file truncated");
+		if (crc32(reinterpret_cast<const uint8_t*>(headerBytes.data()), headerBytes.size()) != headerCrc)
+			throw std::ios_base::failure("Pattern database file header corrupt");
+
+		fileBytes -= std::min(fileBytes, headerLength);
+		std::istringstream header(headerBytes);
+		auto left = [&]() { return headerLength - uint64_t(header.tellg()); };
+		auto inconsistent = []() { return std::ios_base::failure("Pattern database file has inconsistent header"); };
+
+		uint64_t count = readWord(header, 4);
+		if (count > MAX_TABLES)
+			throw inconsistent();
+
+		std::vector<Table> tables(count);
+		std::vector<std::vector<BlockInfo>> info(tables.size());
+		std::vector<uint32_t> blockBytes(tables.size());
+		uint64_t storedBytes = 0;
+
+		for (size_t t = 0; t < tables.size(); t++)
+		{
+			uint64_t length = readWord(header, 4);
+			if (length > left())
+				throw inconsistent();
+
+			tables[t].description.resize(size_t(length));
+			header.read(&tables[t].description[0], tables[t].description.size());
+
+			tables[t].ranking = Ranking(readWord(header, 4));
+			tables[t].n = readWord(header, 8);
+			blockBytes[t] = uint32_t(readWord(header, 4));
+			uint64_t blocks = readWord(header, 4);
+
+			//Each block must be indexed, and its index held within the header
+			uint64_t bytes = tables[t].n / 2;
+			if (blockBytes[t] == 0 || blockBytes[t] > MAX_BLOCK_BYTES || blocks != (bytes + blockBytes[t] - 1) / blockBytes[t]
+				|| blocks > left() / BLOCK_INFO_BYTES)
+				throw inconsistent();
+
+			info[t].resize(size_t(blocks));
+			for (BlockInfo &i : info[t])
+			{
+				i.codec = uint8_t(readWord(header, 1));
+				i.length = uint32_t(readWord(header, 4));
+				i.crc = uint32_t(readWord(header, 4));
+				storedBytes += i.length;
+			}
+		}
+
+		//The blocks indexed must all lie within the file
+		if (storedBytes > fileBytes)
+			throw std::ios_base::failure("Pattern database file truncated");
+
+		for (size_t t = 0; t < tables.size(); t++)
+		{
+			//Read the table's stored blocks in one go
+			std::vector<size_t> offsets(info[t].size() + 1, 0);
+			for (size_t b = 0; b < info[t].size(); b++)
+				offsets[b + 1] = offsets[b] + info[t][b].length;
+
+			std::vector<uint8_t> stored(offsets.back());
+			if (!is.read(reinterpret_cast<char*>(stored.data()), stored.size()))
+				throw std::ios_base::failure("Pattern database file truncated");
+
+			size_t bytes = tables[t].n / 2;
+			std::vector<FourBitIntPair> entries(bytes);
+			uint8_t *data = reinterpret_cast<uint8_t*>(entries.data());
+			std::atomic<bool> valid(true);
+
+			parallelFor(info[t].size(), threads, [&](size_t b)
+			{
+				const BlockInfo &i = info[t][b];
+				uint8_t *block = data + b * blockBytes[t];
+				size_t length = std::min<size_t>(blockBytes[t], bytes - b * blockBytes[t]);
+
+				bool ok;
+				if (i.codec == RAW)
+				{
+					ok = (i.length == length);
+					if (ok)
+						std::memcpy(block, &stored[offsets[b]], length);
+				}
+				else
+					ok = (i.codec == HUFFMAN) && decompressBlock(&stored[offsets[b]], i.length, block, length);
+
+				if (!ok || crc32(block, length) != i.crc)
+					valid = false;
+			});
+
+			if (!valid)
+				throw std::ios_base::failure("Pattern database file corrupt: " + tables[t].description);
+
+			tables[t].pd = PatternDatabase(std::move(entries));
+		}
+
+		return tables;
+	}
+}
@@ -0,0 +1,51 @@
+/**
+ * PatternDatabaseFile.h
+ * Declares reading and writing of the pattern database
+ * container file, which holds any number of tables with a
+ * description of each, split into checksummed blocks that
+ * may be compressed and are decoded in parallel.
+ *
+ * @author Sam Griffiths
+ */
+
+#pragma once
+
+#include "PatternDatabase.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace PatternDatabaseFile
+{
+	//Current version of the format; older files are rejected
+	const uint32_t VERSION = 2;
+
+	//Schemes mapping states to table indices
+	enum Ranking : uint32_t
+	{
+		//Lehmer rank of piece positions, then orientations (getCornerConfigIndex, getEdgeConfigIndex)
+		LEHMER_ORIENTATION = 1
+	};
+
+	//A table within the file
+	struct Table
+	{
+		//Puzzle and pieces covered, e.g. "3x3x3 corners 0-7"
+		std::string description;
+		Ranking ranking;
+
+		//Number of 4-bit values
+		size_t n;
+
+		PatternDatabase pd;
+	};
+
+	//Writes the given tables to the stream, compressing blocks where it
+	//helps, using the given number of threads
+	void write(std::ostream &os, const std::vector<Table> &tables, bool compress = true, size_t threads = 1);
+
+	//Reads all tables from the stream, decoding blocks using the given number
+	//of threads (throws std::ios_base::failure if the file is invalid)
+	std::vector<Table> read(std::istream &is, size_t threads = 1);
+}
@@ -0,0 +1,159 @@
+/**
+ * PrunedIDAstar.h
+ * Implements IDA* search as a recursive walk over a fixed
+ * array of states, skipping operations the node type marks
+ * as redundant after the previous one. Node types must also
+ * provide OPERATIONS (the number of operation codes),
+ * apply(op) returning the child, and the static predicate
+ * redundant(previous, op). Heuristics are tracked along the
+ * path (see HeuristicTracker), the children of each node
+ * being generated and evaluated together before any is
+ * searched.
+ *
+ * @author Sam Griffiths
+ */
+
+#ifndef PrunedIDAstar_H
+#define PrunedIDAstar_H
+
+#include "Search.h"
+
+#include <atomic>
+
+namespace Search
+{
+	//State of one depth-first iteration of PrunedIDAstar
+	template <typename Node, typename Heuristic>
+	struct PrunedIDAstarWalk
+	{
+		using Tracker = HeuristicTracker<Node, Heuristic>;
+
+		const Node &goal;
+		Tracker tracker;
+
+		//Current and next cost limits
+		size_t threshold, thresholdNew;
+
+		//States, their heuristic tracks and operations along the current path, indexed by depth
+		std::vector<Node> states;
+		std::vector<typename Tracker::Track> tracks;
+		Path path;
+
+		//Children of the state at each depth (OPERATIONS per depth), with their tracks and operations
+		std::vector<Node> children;
+		std::vector<typename Tracker::Track> childTracks;
+		Path childOps;
+
+		//Optional flag abandoning the walk once set elsewhere
+		const std::atomic<bool> *cancel;
+
+
+		PrunedIDAstarWalk(const Node &goal, const Heuristic &h)
+			: goal(goal), tracker{ h }, threshold(0), thresholdNew(0), cancel(nullptr) {}
+
+		//Prepares to search below the given root, no deeper than the threshold
+		void reset(const Node &root, const typename Tracker::Track &rootTrack)
+		{
+			states.assign(threshold + 2, root);
+			tracks.assign(threshold + 2, rootTrack);
+			path.assign(threshold + 1, 0);
+			children.assign((threshold + 1) * Node::OPERATIONS, root);
+			childTracks.assign((threshold + 1) * Node::OPERATIONS, rootTrack);
+			childOps.assign((threshold + 1) * Node::OPERATIONS, 0);
+		}
+
+		//Returns true once the goal is found below the node at the given depth
+		bool search(size_t depth, Operation last)
+		{
+			if (cancel && cancel->load(std::memory_order_relaxed))
+				return false;
+
+			const Node &n = states[depth];
+
+			//Check for solution
+			if (n == goal)
+			{
+				path.resize(depth);
+				return true;
+			}
+
+			//Generate every child first, so that their heuristics are evaluated as a batch
+			Node *c = &children[depth * Node::OPERATIONS];
+			typename Tracker::Track *t = &childTracks[depth * Node::OPERATIONS];
+			Operation *ops = &childOps[depth * Node::OPERATIONS];
+			size_t count = 0;
+
+			for (Operation op = 0; op < Node::OPERATIONS; op++)
+			{
+				//Skip operations which cannot lead to a shorter path
+				if (depth > 0 && Node::redundant(last, op))
+					continue;
+
+				c[count] = n.apply(op);
+				ops[count++] = op;
+			}
+
+			/* Children whose heuristic cost reaches threshold - depth are pruned, and
+				only those below thresholdNew - depth - 1 can lower the next threshold,
+				so no child's cost matters beyond the latter */
+			tracker.track(tracks[depth], c, ops, count, t, thresholdNew - depth - 1);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				size_t cost = depth + 1 + tracker.cost(t[i]);
+
+				//If above the threshold, prune and log minimum
+				if (cost > threshold)
+				{
+					if (cost < thresholdNew)
+						thresholdNew = cost;
+					continue;
+				}
+
+				states[depth + 1] = c[i];
+				tracks[depth + 1] = t[i];
+				path[depth] = ops[i];
+				if (search(depth + 1, ops[i]))
+					return true;
+			}
+
+			return false;
+		}
+	};
+
+	template <typename Node>
+	Path PrunedIDAstar(const Node &start, const Node &goal, HeuristicFunc<Node> h)
+	{
+		return PrunedIDAstar(start, goal, FixedGoalHeuristic<Node>{ h, goal });
+	}
+
+	template <typename Node, typename Heuristic>
+	Path PrunedIDAstar(const Node &start, const Node &goal, const Heuristic &h)
+	{
+		PrunedIDAstarWalk<Node, Heuristic> walk(goal, h);
+		typename PrunedIDAstarWalk<Node, Heuristic>::Tracker::Track startTrack = walk.tracker.track(start);
+		walk.threshold = walk.tracker.cost(startTrack);
+
+		while (true)
+		{
+			//Tracker for the minimum of pruned costs
+			walk.thresholdNew = std::numeric_limits<size_t>::max();
+
+			//No path within this iteration can be deeper than the threshold
+			walk.reset(start, startTrack);
+
+			//Perform DFS iteration
+			if (walk.search(0, 0))
+				return walk.path;
+
+			//Nothing was pruned, so no solution exists
+			if (walk.thresholdNew == std::numeric_limits<size_t>::max())
+				return Path();
+
+			//Update threshold for next iteration
+			walk.threshold = walk.thresholdNew;
+		}
+	}
+}
+
+#endif
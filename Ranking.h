@@ -0,0 +1,115 @@
+/**
+ * Ranking.h
+ * Declares perfect ranking and unranking of partial
+ * permutations (Lehmer codes) and of orientation digits,
+ * from which the pattern database indices are built. The
+ * positions already taken are kept as a bitmask, so each
+ * Lehmer digit is a popcount, and each digit's weight is
+ * read from a table. Both tables are built at compile time,
+ * popcounts being looked up so as not to depend on the
+ * instruction set targeted.
+ *
+ * @author Sam Griffiths
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//Largest number of positions ranked over (the edges)
+const size_t RANKING_MAX_POSITIONS = 12;
+
+//Table of a! / (a - b)!, the ordered arrangements of b items from a
+struct ArrangementTable
+{
+	size_t value[RANKING_MAX_POSITIONS + 1][RANKING_MAX_POSITIONS + 1];
+
+	constexpr ArrangementTable() : value()
+	{
+		for (size_t a = 0; a <= RANKING_MAX_POSITIONS; a++)
+		{
+			value[a][0] = 1;
+			for (size_t b = 1; b <= a; b++)
+				value[a][b] = value[a][b - 1] * (a - b + 1);
+		}
+	}
+};
+
+constexpr ArrangementTable ARRANGEMENTS;
+
+//Table of the number of bits set in each mask of the positions
+struct PopcountTable
+{
+	uint8_t value[1 << RANKING_MAX_POSITIONS];
+
+	constexpr PopcountTable() : value()
+	{
+		for (size_t i = 1; i < (1 << RANKING_MAX_POSITIONS); i++)
+			value[i] = uint8_t(value[i / 2] + i % 2);
+	}
+};
+
+constexpr PopcountTable POPCOUNTS;
+
+//Number of ordered arrangements of b items from a
+inline size_t arrangements(size_t a, size_t b)
+{
+	return ARRANGEMENTS.value[a][b];
+}
+
+//Lehmer rank of k distinct positions out of n
+inline size_t rankPositions(const uint8_t *p, size_t k, size_t n)
+{
+	size_t index = 0;
+	uint32_t used = 0;
+
+	for (size_t i = 0; i < k; i++)
+	{
+		//Unused positions before this one: all before it, less those used
+		size_t c = p[i] - POPCOUNTS.value[used & ((1u << p[i]) - 1)];
+		used |= 1u << p[i];
+		index += c * ARRANGEMENTS.value[n - 1 - i][k - 1 - i];
+	}
+
+	return index;
+}
+
+//Inverse of rankPositions
+inline void unrankPositions(size_t index, uint8_t *p, size_t k, size_t n)
+{
+	//Ranks over at most 12 positions fit 32 bits, keeping the divisions cheap
+	uint32_t rest = uint32_t(index), used = 0;
+
+	for (size_t i = 0; i < k; i++)
+	{
+		uint32_t w = uint32_t(ARRANGEMENTS.value[n - 1 - i][k - 1 - i]);
+		uint32_t c = rest / w;
+		rest -= c * w;
+
+		//Take the c-th unused position, clearing the lowest unused bit c times
+		uint32_t unused = ~used & ((1u << n) - 1);
+		for (; c > 0; c--)
+			unused &= unused - 1;
+
+		uint8_t j = POPCOUNTS.value[(unused & (~unused + 1)) - 1];
+		p[i] = j;
+		used |= 1u << j;
+	}
+}
+
+//Rank of the given digits in the given base, most significant first
+inline size_t rankDigits(const uint8_t *d, size_t count, size_t base)
+{
+	size_t index = 0;
+	for (size_t i = 0; i < count; i++)
+		index = index * base + d[i];
+	return index;
+}
+
+//Inverse of rankDigits
+inline void unrankDigits(size_t index, uint8_t *d, size_t count, size_t base)
+{
+	for (size_t i = count; i-- > 0; index /= base)
+		d[i] = uint8_t(index % base);
+}
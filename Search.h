@@ -2,8 +2,9 @@
  * Search.h
  * Declares type definitions and functions representing
  * AI state space search. Custom node types will implement
- * expand(), returning a vector of Edges, and also the 
- * equality operator and hash function object.
+ * expand(visit), calling visit(child, operation) for each
+ * child in place, and also the equality operator and hash
+ * function object.
  *
  * Define SEARCH_DEBUG to activate debug mode for searching.
  *
@@ -16,6 +17,11 @@
 #include <string>
 #include <iostream>
 #include <functional>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
 
 #include <deque>
 #include <unordered_set>
@@ -30,22 +36,178 @@
 
 namespace Search
 {
-	//Edge has an operation represented by a string
+	//Operations are small integer codes defined by the node type
+	using Operation = uint8_t;
+
+	//Edge has an operation represented by its code
 	template <typename Node>
-	using Edge = std::pair<Node, std::string>;
+	using Edge = std::pair<Node, Operation>;
 
-	//Path is a list of operations (strings)
-	using Path = std::vector<std::string>;
+	//Path is a list of operations (codes)
+	using Path = std::vector<Operation>;
 
 	//Heuristic function returns a double from 2 Nodes
 	template <typename Node>
 	using HeuristicFunc = std::function<double(const Node&, const Node&)>;
 
+	/* Heuristic policies are instead types called on a single Node
+		(the goal being implicit), typically returning a small integer.
+		Searches taking them are templated on the type, allowing the
+		heuristic to be inlined into the search loop. */
+
+	//Adapts a HeuristicFunc to a heuristic policy by fixing its goal
+	template <typename Node>
+	struct FixedGoalHeuristic
+	{
+		const HeuristicFunc<Node> &h;
+		const Node &goal;
+
+		double operator()(const Node &n) const { return h(n, goal); }
+	};
+
+	//Rounds a heuristic value up to a whole number of operations
+	template <typename T>
+	size_t wholeCost(T h)
+	{
+		if constexpr (std::is_integral<T>::value)
+			return size_t(h);
+		else
+			return size_t(std::ceil(h));
+	}
+
+	/* A heuristic policy may also split its evaluation in two, so that
+		the memory read for a batch of sibling nodes is requested for all
+		of them before any is waited on. Such a policy defines a Probe
+		type, probe(n) locating a node's values and prefetching them, and
+		operator()(probe) reading them. A policy whose values are located
+		through a table of their own may also define refine(probe), run
+		over the batch in between, to finish locating them once the reads
+		probe prefetched have arrived. Searches use HeuristicBatch, which
+		evaluates other policies one node at a time. */
+	template <typename Heuristic, typename = void>
+	struct RefinesProbe : std::false_type {};
+
+	template <typename Heuristic>
+	struct RefinesProbe<Heuristic, std::void_t<decltype(std::declval<const Heuristic&>().refine(
+		std::declval<typename Heuristic::Probe&>()))>> : std::true_type {};
+
+	template <typename Node, typename Heuristic, typename = void>
+	struct HeuristicBatch
+	{
+		using Value = decltype(std::declval<const Heuristic&>()(std::declval<const Node&>()));
+
+		const Heuristic &h;
+
+		void evaluate(const Node *nodes, size_t count, Value *values) const
+		{
+			for (size_t i = 0; i < count; i++)
+				values[i] = h(nodes[i]);
+		}
+	};
+
+	template <typename Node, typename Heuristic>
+	struct HeuristicBatch<Node, Heuristic, std::void_t<typename Heuristic::Probe>>
+	{
+		using Value = decltype(std::declval<const Heuristic&>()(std::declval<const Node&>()));
+
+		//Nodes probed before the first is read
+		static const size_t SIZE = 32;
+
+		const Heuristic &h;
+
+		void evaluate(const Node *nodes, size_t count, Value *values) const
+		{
+			typename Heuristic::Probe probes[SIZE];
+
+			for (size_t first = 0; first < count; first += SIZE)
+			{
+				size_t last = std::min(count, first + SIZE);
+
+				for (size_t i = first; i < last; i++)
+					probes[i - first] = h.probe(nodes[i]);
+
+				if constexpr (RefinesProbe<Heuristic>::value)
+					for (size_t i = first; i < last; i++)
+						h.refine(probes[i - first]);
+
+				for (size_t i = first; i < last; i++)
+					values[i] = h(probes[i - first]);
+			}
+		}
+	};
+
+	/* A heuristic policy may also be tracked along a search path, where
+		a child's value is cheaper to find from its parent's. Such a
+		policy defines a Track type, track(n) giving the Track of a node
+		from scratch, track(parent, child, op) that of a child from its
+		parent's, and cost(t) its value as a whole number. It may also
+		define track(parent, children, ops, count, tracks, bound), tracking
+		all the children of a node at once: the search neither expands any
+		child costing at least bound nor takes its cost as the next
+		threshold, so its cost may stop anywhere short of its value once it
+		reaches bound. Searches use HeuristicTracker, which
+		tracks other policies by plain value, evaluating the children of a
+		node as a batch. */
+	template <typename Node, typename Heuristic, typename = void>
+	struct TracksBatch : std::false_type {};
+
+	template <typename Node, typename Heuristic>
+	struct TracksBatch<Node, Heuristic, std::void_t<decltype(std::declval<const Heuristic&>().track(
+		std::declval<const typename Heuristic::Track&>(), std::declval<const Node*>(), std::declval<const Operation*>(),
+		size_t(), std::declval<typename Heuristic::Track*>(), size_t()))>> : std::true_type {};
+
+	template <typename Node, typename Heuristic, typename = void>
+	struct HeuristicTracker
+	{
+		using Track = decltype(std::declval<const Heuristic&>()(std::declval<const Node&>()));
+
+		const Heuristic &h;
+
+		Track track(const Node &n) const { return h(n); }
+		Track track(const Track&, const Node &child, Operation) const { return h(child); }
+		size_t cost(const Track &t) const { return wholeCost(t); }
+
+		//Tracks the given children of a node at once, those costing at least the given bound
+		//being pruned without lowering the next threshold (see above)
+		void track(const Track&, const Node *children, const Operation*, size_t count, Track *tracks,
+			size_t = std::numeric_limits<size_t>::max()) const
+		{
+			HeuristicBatch<Node, Heuristic>{ h }.evaluate(children, count, tracks);
+		}
+	};
+
+	template <typename Node, typename Heuristic>
+	struct HeuristicTracker<Node, Heuristic, std::void_t<typename Heuristic::Track>>
+	{
+		using Track = typename Heuristic::Track;
+
+		const Heuristic &h;
+
+		Track track(const Node &n) const { return h.track(n); }
+		Track track(const Track &parent, const Node &child, Operation op) const { return h.track(parent, child, op); }
+		size_t cost(const Track &t) const { return h.cost(t); }
+
+		void track(const Track &parent, const Node *children, const Operation *ops, size_t count, Track *tracks,
+			size_t bound = std::numeric_limits<size_t>::max()) const
+		{
+			if constexpr (TracksBatch<Node, Heuristic>::value)
+				h.track(parent, children, ops, count, tracks, bound);
+			else
+				for (size_t i = 0; i < count; i++)
+					tracks[i] = h.track(parent, children[i], ops[i]);
+		}
+	};
+
+
+	//Arena of the nodes a search has generated, optionally keyed (see NodeStore)
+	template <typename Node, bool Keyed = false>
+	class NodeStore;
+
 
 	/* SEARCH ALGORITHMS */
 
-	//Breadth-first search
-	template <typename Node>
+	//Breadth-first search, its nodes held in the given store
+	template <typename Node, typename Store = NodeStore<Node>>
 	Path BFS(const Node &start, const Node &goal);
 
 	//Depth-first search (empty Path if not found)
@@ -56,17 +218,35 @@ namespace Search
 	template <typename Node>
 	Path IDDFS(const Node &start, const Node &goal);
 
-	//Pure heuristic search (greedy best-first)
+	//Pure heuristic search (greedy best-first), its nodes held in the given store
 	template <typename Node>
 	Path PHS(const Node &start, const Node &goal, HeuristicFunc<Node> h);
+	template <typename Node, typename Heuristic, typename Store = NodeStore<Node>>
+	Path PHS(const Node &start, const Node &goal, const Heuristic &h);
 
-	//A* search
+	//A* search, its nodes held in the given store
 	template <typename Node>
 	Path Astar(const Node &start, const Node &goal, HeuristicFunc<Node> h);
+	template <typename Node, typename Heuristic, typename Store = NodeStore<Node>>
+	Path Astar(const Node &start, const Node &goal, const Heuristic &h);
 
 	//Iterative deepening A* search
 	template <typename Node>
 	Path IDAstar(const Node &start, const Node &goal, HeuristicFunc<Node> h);
+	template <typename Node, typename Heuristic>
+	Path IDAstar(const Node &start, const Node &goal, const Heuristic &h);
+
+	//Recursive IDA* search with node-defined operation pruning
+	template <typename Node>
+	Path PrunedIDAstar(const Node &start, const Node &goal, HeuristicFunc<Node> h);
+	template <typename Node, typename Heuristic>
+	Path PrunedIDAstar(const Node &start, const Node &goal, const Heuristic &h);
+
+	//PrunedIDAstar split into subtrees at the given depth, searched by the given number of threads
+	template <typename Node>
+	Path ParallelIDAstar(const Node &start, const Node &goal, HeuristicFunc<Node> h, size_t threads, size_t splitDepth);
+	template <typename Node, typename Heuristic>
+	Path ParallelIDAstar(const Node &start, const Node &goal, const Heuristic &h, size_t threads, size_t splitDepth);
 
 
 
@@ -82,9 +262,14 @@ namespace Search
 	}
 }
 
+#include "BucketQueue.h"
+#include "NodeStore.h"
+
 #include "BFS.h"
 #include "DFS.h"
 #include "IDDFS.h"
 #include "PHS.h"
 #include "Astar.h"
 #include "IDAstar.h"
+#include "PrunedIDAstar.h"
+#include "ParallelIDAstar.h"
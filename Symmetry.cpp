@@ -0,0 +1,212 @@
+/**
+ * Symmetry.cpp
+ * Implements the Symmetry class, a rotation or reflection of
+ * the whole Cube.
+ *
+ * @author Sam Griffiths
+ */
+
+#include "Symmetry.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+	//Faces in the order of the move enumeration
+	const char FACES[] = "UDRLFB";
+
+	//Returns the index of the given face letter, or 6 if none
+	size_t faceIndex(char face)
+	{
+		size_t f = 0;
+		while (f < 6 && FACES[f] != face)
+			f++;
+		return f;
+	}
+
+	/* Finds the position and orientation of an edge (n = 2) or corner
+		(n = 3) whose facets lie on the given faces, facet by facet,
+		returning its encoded byte; 0xFF if there is none. */
+	uint8_t encodeFacets(const char *faces, size_t n)
+	{
+		if (n == 2)
+		{
+			for (uint8_t p = 0; p < Cube::NUMBER_OF_EDGES; p++)
+				for (uint8_t o = 0; o < 2; o++)
+					if (faces[0] == Cube::EDGE_POSITIONS[p][o] && faces[1] == Cube::EDGE_POSITIONS[p][1 - o])
+						return uint8_t(p | (o << 4));
+		}
+		else
+		{
+			for (uint8_t p = 0; p < Cube::NUMBER_OF_CORNERS; p++)
+				for (uint8_t o = 0; o < 3; o++)
+					if (faces[0] == Cube::CORNER_POSITIONS[p][o] && faces[1] == Cube::CORNER_POSITIONS[p][(o + 1) % 3]
+						&& faces[2] == Cube::CORNER_POSITIONS[p][(o + 2) % 3])
+						return uint8_t(p | (o << 4));
+		}
+
+		return 0xFF;
+	}
+
+	//Returns the faces the facets of the given encoded piece lie on, as Cube::decode does
+	void decodeFacets(uint8_t x, size_t n, char *faces)
+	{
+		uint8_t position = x & 15, orientation = x >> 4;
+		const char *p = (n == 2) ? Cube::EDGE_POSITIONS[position] : Cube::CORNER_POSITIONS[position];
+
+		for (size_t k = 0; k < n; k++)
+			faces[k] = p[(orientation + k) % n];
+	}
+}
+
+Symmetry::Symmetry(const char *faces)
+{
+	//Each face must be carried onto a distinct face, opposite faces staying opposite
+	for (size_t f = 0; f < 6; f++)
+	{
+		image[f] = faces[f];
+		if (faceIndex(image[f]) == 6 || std::count(image, image + f, image[f]) > 0)
+			throw std::invalid_argument("Invalid symmetry");
+	}
+
+	image[6] = '\0';
+
+	for (size_t f = 0; f < 6; f += 2)
+		if (faceIndex(image[f]) / 2 != faceIndex(image[f + 1]) / 2)
+			throw std::invalid_argument("Invalid symmetry");
+
+	auto carry = [this](char face) { return image[faceIndex(face)]; };
+
+	/* Relabels every encoded byte of each piece: the facet whose goal face
+		is g, lying on face c, is carried to face carry(c), and is the facet
+		of the relabelled piece whose goal face is carry(g). */
+	auto build = [&carry](size_t n, size_t pieces, size_t orientations, uint8_t *relabelled, uint8_t *bytes, size_t stride)
+	{
+		for (size_t i = 0; i < pieces; i++)
+		{
+			char goal[3], carried[3];
+			decodeFacets(uint8_t(i), n, goal);
+			for (size_t k = 0; k < n; k++)
+				carried[k] = carry(goal[k]);
+
+			//The relabelled piece, with its facets in its own order
+			uint8_t j = encodeFacets(carried, n);
+			if (j == 0xFF && n == 3)
+			{
+				//Reflections reverse the order of a corner's facets
+				std::swap(carried[1], carried[2]);
+				j = encodeFacets(carried, n);
+			}
+			j &= 15;
+			relabelled[i] = j;
+
+			char own[3];
+			decodeFacets(j, n, own);
+
+			for (size_t position = 0; position < pieces; position++)
+				for (size_t orientation = 0; orientation < orientations; orientation++)
+				{
+					uint8_t x = uint8_t(position | (orientation << 4));
+					char current[3], result[3];
+					decodeFacets(x, n, current);
+
+					for (size_t m = 0; m < n; m++)
+						for (size_t k = 0; k < n; k++)
+							if (carry(goal[k]) == own[m])
+								result[m] = carry(current[k]);
+
+					bytes[i * stride + x] = encodeFacets(result, n);
+				}
+		}
+	};
+
+	build(2, Cube::NUMBER_OF_EDGES, 2, edgePieces, &edgeBytes[0][0], 32);
+	build(3, Cube::NUMBER_OF_CORNERS, 3, cornerPieces, &cornerBytes[0][0], 48);
+
+	for (size_t i = 0; i < Cube::NUMBER_OF_EDGES; i++)
+		edgeSources[edgePieces[i]] = uint8_t(i);
+	for (size_t i = 0; i < Cube::NUMBER_OF_CORNERS; i++)
+		cornerSources[cornerPieces[i]] = uint8_t(i);
+
+	//A reflection carries the faces of a corner, in order, onto those of a corner in reverse order
+	char corner[3] = { carry(Cube::CORNER_POSITIONS[0][0]), carry(Cube::CORNER_POSITIONS[0][1]),
+		carry(Cube::CORNER_POSITIONS[0][2]) };
+	reflects = encodeFacets(corner, 3) == 0xFF;
+
+	//Turns are carried onto turns of the carried face, reversed by a reflection
+	for (size_t m = 0; m < Cube::NUMBER_OF_MOVES; m++)
+	{
+		size_t face = faceIndex(image[m / 3]), dir = m % 3;
+		if (reflects && dir < 2)
+			dir = 1 - dir;
+		moves[m] = Cube::Move(face * 3 + dir);
+	}
+}
+
+Cube Symmetry::conjugate(const Cube &cube) const
+{
+	Cube result;
+
+	for (size_t i = 0; i < Cube::NUMBER_OF_EDGES; i++)
+		result.edges[edgePieces[i]] = edgeBytes[i][cube.edges[i]];
+
+	for (size_t i = 0; i < Cube::NUMBER_OF_CORNERS; i++)
+		result.corners[cornerPieces[i]] = cornerBytes[i][cube.corners[i]];
+
+	return result;
+}
+
+Symmetry Symmetry::inverse() const
+{
+	//The face carried onto each face
+	char faces[7] = {};
+	for (size_t f = 0; f < 6; f++)
+		faces[faceIndex(image[f])] = FACES[f];
+
+	return Symmetry(faces);
+}
+
+const std::vector<Symmetry>& Symmetry::all()
+{
+	static const std::vector<Symmetry> symmetries = []
+	{
+		//Each axis may be carried onto any axis, either way round
+		const char *axes[] = { "UD", "RL", "FB" };
+		size_t order[] = { 0, 1, 2 };
+		std::vector<Symmetry> result;
+
+		do
+		{
+			for (size_t flips = 0; flips < 8; flips++)
+			{
+				char faces[7] = {};
+				for (size_t a = 0; a < 3; a++)
+				{
+					bool flip = (flips >> a) & 1;
+					faces[2 * a] = axes[order[a]][flip];
+					faces[2 * a + 1] = axes[order[a]][!flip];
+				}
+				result.emplace_back(faces);
+			}
+		} while (std::next_permutation(order, order + 3));
+
+		return result;
+	}();
+
+	return symmetries;
+}
+
+const Symmetry* Symmetry::carrying(const std::vector<uint8_t> &edges, const std::vector<uint8_t> &onto)
+{
+	if (edges.size() != onto.size())
+		return nullptr;
+
+	for (const Symmetry &s : all())
+		if (std::all_of(edges.begin(), edges.end(), [&](uint8_t e) {
+			return std::count(onto.begin(), onto.end(), s.edge(e)) > 0; }))
+			return &s;
+
+	return nullptr;
+}
@@ -0,0 +1,78 @@
+/**
+ * Symmetry.h
+ * Declares the Symmetry class, a rotation or reflection of
+ * the whole Cube. A symmetry carries every move sequence
+ * onto one of the same length, so the distance of a set of
+ * pieces from the goal is that of the set it is carried
+ * onto, in the state seen through the symmetry.
+ *
+ * @author Sam Griffiths
+ */
+
+#pragma once
+
+#include "Cube.h"
+
+#include <cstdint>
+#include <vector>
+
+class Symmetry
+{
+public:
+	//Builds the symmetry carrying the faces U D R L F B onto the given faces, in that order
+	//(throws std::invalid_argument unless they are those of a rotation or reflection)
+	explicit Symmetry(const char *faces);
+
+	/* Returns the state seen through the symmetry: each piece is carried
+		where the symmetry takes it, and relabelled as the piece whose
+		goal position its own is carried onto. The goal is left as is. */
+	Cube conjugate(const Cube &cube) const;
+
+	//Returns the encoded byte of the given edge piece in the state seen through the symmetry,
+	//for when only some pieces are needed
+	uint8_t conjugateEdge(const Cube &cube, size_t j) const
+	{
+		size_t i = edgeSources[j];
+		return edgeBytes[i][cube.edges[i]];
+	}
+
+	//Returns the encoded byte of the given corner piece in the state seen through the symmetry
+	uint8_t conjugateCorner(const Cube &cube, size_t j) const
+	{
+		size_t i = cornerSources[j];
+		return cornerBytes[i][cube.corners[i]];
+	}
+
+	//Returns the move carried onto by the given move
+	Cube::Move conjugate(Cube::Move m) const { return moves[m]; }
+
+	//Returns the piece the given edge or corner piece is relabelled as
+	uint8_t edge(size_t i) const { return edgePieces[i]; }
+	uint8_t corner(size_t i) const { return cornerPieces[i]; }
+
+	//Whether the symmetry is a reflection, reversing the direction of turns
+	bool reflection() const { return reflects; }
+
+	//Returns the faces U D R L F B are carried onto, in that order
+	const char* faces() const { return image; }
+
+	//Returns the symmetry undoing this one
+	Symmetry inverse() const;
+
+	//Returns all 48 symmetries of the Cube, the identity first
+	static const std::vector<Symmetry>& all();
+
+	//Returns the first symmetry carrying the given edge pieces onto the other given ones
+	//(the identity, if it will do), or nullptr if none does
+	static const Symmetry* carrying(const std::vector<uint8_t> &edges, const std::vector<uint8_t> &onto);
+
+private:
+	//Relabelled piece, and (piece, encoded byte) -> encoded byte of the relabelled piece
+	uint8_t edgePieces[Cube::NUMBER_OF_EDGES], cornerPieces[Cube::NUMBER_OF_CORNERS];
+	uint8_t edgeSources[Cube::NUMBER_OF_EDGES], cornerSources[Cube::NUMBER_OF_CORNERS];
+	uint8_t edgeBytes[Cube::NUMBER_OF_EDGES][32], cornerBytes[Cube::NUMBER_OF_CORNERS][48];
+
+	Cube::Move moves[Cube::NUMBER_OF_MOVES];
+	bool reflects;
+	char image[7];
+};
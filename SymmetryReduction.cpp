@@ -0,0 +1,139 @@
+/**
+ * SymmetryReduction.cpp
+ * Implements the SymmetryReduction class, indexing the
+ * configurations of a set of pieces by their classes under
+ * the symmetries that carry the set onto itself.
+ *
+ * @author Sam Griffiths
+ */
+
+#include "SymmetryReduction.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+SymmetryReduction::SymmetryReduction()
+	: corners(true), pieces{ 0, 1, 2, 3, 4, 5, 6, 7 }, k(8), positions(8), base(3), orientationDigits(7), orientations(2187)
+{
+	build();
+}
+
+SymmetryReduction::SymmetryReduction(const std::vector<uint8_t> &edges)
+	: corners(false), pieces(edges), k(edges.size()), positions(12), base(2), orientationDigits(edges.size()),
+	orientations(size_t(1) << edges.size())
+{
+	if (k < 1 || k > 8)
+		throw std::invalid_argument("Edge pattern must have 1-8 pieces");
+
+	build();
+}
+
+void SymmetryReduction::build()
+{
+	const std::vector<Symmetry> &all = Symmetry::all();
+	symmetryList = all.data();
+
+	//Keep the symmetries carrying every piece onto one of the set
+	for (size_t a = 0; a < all.size(); a++)
+		if (std::all_of(pieces.begin(), pieces.end(), [&](uint8_t p) {
+			return std::count(pieces.begin(), pieces.end(), corners ? all[a].corner(p) : all[a].edge(p)) > 0; }))
+			group.push_back(uint8_t(a));
+
+	//Index of the inverse of each symmetry
+	std::vector<uint8_t> inverse(all.size());
+	for (size_t a = 0; a < all.size(); a++)
+	{
+		Symmetry inv = all[a].inverse();
+		for (size_t b = 0; b < all.size(); b++)
+			if (std::strcmp(all[b].faces(), inv.faces()) == 0)
+				inverse[a] = uint8_t(b);
+	}
+
+	/* Each arrangement not yet classed is a new representative: every
+		arrangement a symmetry carries it onto joins its class, carried
+		back onto it by the inverse symmetry. */
+	const uint32_t UNCLASSED = ~uint32_t(0);
+	classes.assign(arrangements(positions, k), UNCLASSED);
+
+	for (size_t r = 0; r < classes.size(); r++)
+	{
+		if (classes[r] != UNCLASSED)
+			continue;
+
+		uint32_t c = uint32_t(representatives.size());
+		representatives.push_back(uint32_t(r));
+		stabilizers.push_back(0);
+
+		uint8_t digits[RANKING_DIGITS];
+		unrankPositions(r, digits, k, positions);
+
+		Cube cube;
+		uint8_t *bytes = corners ? cube.corners : cube.edges;
+		for (size_t i = 0; i < k; i++)
+			bytes[pieces[i]] = digits[i];
+
+		for (uint8_t a : group)
+		{
+			for (size_t i = 0; i < k; i++)
+				digits[i] = (corners ? all[a].conjugateCorner(cube, pieces[i]) : all[a].conjugateEdge(cube, pieces[i])) & 15;
+
+			size_t q = rankPositions(digits, k, positions);
+			if (classes[q] == UNCLASSED)
+				classes[q] = c << SYMMETRY_BITS | inverse[a];
+			else if (q == r && a != 0)
+				stabilizers[c] |= uint64_t(1) << a;
+		}
+	}
+
+	//The values are packed in pairs, so repeat a class if need be to make the size even
+	if (size() % 2 != 0)
+	{
+		representatives.push_back(representatives.back());
+		stabilizers.push_back(stabilizers.back());
+	}
+}
+
+size_t SymmetryReduction::leastOrientation(const Cube &cube, uint64_t symmetries, size_t orientation) const
+{
+	const std::vector<Symmetry> &all = Symmetry::all();
+	uint8_t digits[RANKING_DIGITS];
+
+	for (size_t a = 1; a < all.size(); a++)
+		if ((symmetries >> a) & 1)
+		{
+			for (size_t i = 0; i < k; i++)
+				digits[i] = (corners ? all[a].conjugateCorner(cube, pieces[i]) : all[a].conjugateEdge(cube, pieces[i])) >> 4;
+			orientation = std::min(orientation, rankDigits(digits, orientationDigits, base));
+		}
+
+	return orientation;
+}
+
+Cube SymmetryReduction::configuration(size_t index) const
+{
+	uint8_t p[RANKING_DIGITS], o[RANKING_DIGITS] = {};
+	unrankPositions(representatives[index / orientations], p, k, positions);
+	unrankDigits(index % orientations, o, orientationDigits, base);
+
+	//The last corner's orientation is fixed by the others
+	if (corners)
+	{
+		size_t sum = 0;
+		for (size_t i = 0; i < orientationDigits; i++)
+			sum += o[i];
+		o[orientationDigits] = uint8_t((3 - sum % 3) % 3);
+	}
+
+	Cube cube;
+	uint8_t *bytes = corners ? cube.corners : cube.edges;
+	for (size_t i = 0; i < k; i++)
+		bytes[pieces[i]] = uint8_t(p[i] | o[i] << 4);
+
+	return cube;
+}
+
+size_t SymmetryReduction::twist(size_t index, Cube::Move m) const
+{
+	return this->index(configuration(index).twist(m));
+}
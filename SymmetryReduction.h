@@ -0,0 +1,147 @@
+/**
+ * SymmetryReduction.h
+ * Declares the SymmetryReduction class, indexing the
+ * configurations of a set of pieces by their classes under
+ * the symmetries that carry the set onto itself. Members of
+ * a class lie at the same distance from the goal, so a
+ * pattern database need hold only one entry per class: all
+ * 48 symmetries apply to the corners, shrinking their
+ * database some 40 times, and 16 to an edge set such as
+ * the U and D layer edges.
+ *
+ * @author Sam Griffiths
+ */
+
+#pragma once
+
+#include "Cube.h"
+#include "Ranking.h"
+#include "Symmetry.h"
+
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <xmmintrin.h>
+#endif
+
+/* The permutation part of a configuration (the positions the pieces
+	occupy) is reduced by table: each arrangement is mapped to its class,
+	and to a symmetry carrying it onto the class's representative. The
+	configuration is then seen through that symmetry, and its orientation
+	part ranked as usual. A reduced index is thus (class * orientations +
+	orientation), all orientations of a representative being kept. */
+class SymmetryReduction
+{
+public:
+	//Reduces the configurations of all 8 corners
+	SymmetryReduction();
+
+	//Reduces the configurations of the given edge pieces (1-8 of them)
+	explicit SymmetryReduction(const std::vector<uint8_t> &edges);
+
+	//Number of reduced indices, the size of a reduced pattern database
+	size_t size() const { return representatives.size() * orientations; }
+
+	//Number of symmetries carrying the pieces onto themselves
+	size_t symmetries() const { return group.size(); }
+
+	//Returns the rank of the positions the given Cube's pieces occupy, by which their class is found
+	size_t arrangement(const Cube &cube) const
+	{
+		uint8_t digits[RANKING_DIGITS];
+		const uint8_t *bytes = corners ? cube.corners : cube.edges;
+		for (size_t i = 0; i < k; i++)
+			digits[i] = bytes[pieces[i]] & 15;
+
+		return rankPositions(digits, k, positions);
+	}
+
+	//Hints that the class of the given arrangement is about to be read, so that it
+	//can be fetched while other work goes on
+	void prefetch(size_t arrangement) const
+	{
+	#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		_mm_prefetch(reinterpret_cast<const char*>(&classes[arrangement]), _MM_HINT_T0);
+	#elif defined(__GNUC__)
+		__builtin_prefetch(&classes[arrangement]);
+	#endif
+	}
+
+	//Returns the reduced index of the given Cube's configuration, of the given arrangement
+	size_t index(const Cube &cube, size_t arrangement) const
+	{
+		uint32_t c = classes[arrangement];
+
+		//See the configuration through the symmetry carrying it onto the representative
+		const Symmetry &s = symmetryList[c & SYMMETRY_MASK];
+		uint8_t digits[RANKING_DIGITS];
+		for (size_t i = 0; i < k; i++)
+			digits[i] = (corners ? s.conjugateCorner(cube, pieces[i]) : s.conjugateEdge(cube, pieces[i])) >> 4;
+
+		size_t orientation = rankDigits(digits, orientationDigits, base);
+		c >>= SYMMETRY_BITS;
+
+		//A representative some symmetries fix is seen through each of them, keeping the least rank
+		if (stabilizers[c] != 0)
+			orientation = leastOrientation(s.conjugate(cube), stabilizers[c], orientation);
+
+		return c * orientations + orientation;
+	}
+
+	//Returns the reduced index of the given Cube's configuration
+	size_t index(const Cube &cube) const { return index(cube, arrangement(cube)); }
+
+	//Returns the given Cube seen through the given symmetry, as far as the pieces go
+	Cube view(const Cube &cube, const Symmetry &s) const
+	{
+		Cube result;
+		for (size_t i = 0; i < k; i++)
+		{
+			if (corners)
+				result.corners[pieces[i]] = s.conjugateCorner(cube, pieces[i]);
+			else
+				result.edges[pieces[i]] = s.conjugateEdge(cube, pieces[i]);
+		}
+
+		return result;
+	}
+
+	//Returns the reduced index reached by applying the given move to the given one's configuration
+	size_t twist(size_t index, Cube::Move m) const;
+
+private:
+	static const size_t RANKING_DIGITS = 12;
+
+	//A class and symmetry are packed as (class << SYMMETRY_BITS | symmetry)
+	static const size_t SYMMETRY_BITS = 6;
+	static const uint32_t SYMMETRY_MASK = (1u << SYMMETRY_BITS) - 1;
+
+	bool corners;
+	std::vector<uint8_t> pieces;
+	size_t k, positions, base, orientationDigits, orientations;
+
+	//Indices of the symmetries carrying the pieces onto themselves, into Symmetry::all
+	std::vector<uint8_t> group;
+	const Symmetry *symmetryList;
+
+	//Arrangement rank -> class and symmetry, and class -> arrangement rank of its representative
+	std::vector<uint32_t> classes;
+	std::vector<uint32_t> representatives;
+
+	/* Class -> mask of the symmetries (other than the identity) fixing its
+		representative. Each configuration of such a class may be seen
+		through any of them, so its index is the least so found; the other
+		indices of the class are never reached, making each class's entries
+		distinct states, as the breadth-first generation requires. */
+	std::vector<uint64_t> stabilizers;
+
+	//Finds the symmetries and classes, once the pieces are known
+	void build();
+
+	//Returns the least orientation rank of the given configuration of a representative,
+	//seen through each of the given symmetries, or the given rank if less
+	size_t leastOrientation(const Cube &cube, uint64_t symmetries, size_t orientation) const;
+
+	//Returns a Cube in the configuration of the given reduced index, the other pieces solved
+	Cube configuration(size_t index) const;
+};
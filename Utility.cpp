@@ -7,8 +7,13 @@
 */
 
 #include "Utility.h"
+#include "Coordinates.h"
+#include "Ranking.h"
 
+#include <atomic>
+#include <memory>
 #include <random>
+#include <thread>
 
 Cube generateCubeProblem(size_t depth, bool print)
 {
@@ -42,352 +47,317 @@ Cube generateCubeProblem(size_t depth, bool print)
 	return c;
 }
 
-void generateManhattanTable(std::ostream &os)
+namespace
 {
-	for (size_t i = 0; i < 12; i++)
+	//Face letters of the given edge or corner state, as written to the Manhattan table file
+	std::string manhattanStateString(size_t state, bool corner)
 	{
-		std::deque<std::pair<CubeNode, size_t>> open;
-		open.push_back({ GOAL_CUBE_NODE, 0 });
-
-		std::unordered_set<CubeNode> closed;
-		std::unordered_set<Cube::Cubie> found;
-		found.insert(open.front().first.cube.cubies[i]);
-
-		while (found.size() < 23)
+		if (!corner)
 		{
-			std::pair<CubeNode, size_t> n = open.front();
-			open.pop_front();
-			closed.insert(n.first);
+			const char *p = Cube::EDGE_POSITIONS[state % Cube::NUMBER_OF_EDGES];
+			return (state < Cube::NUMBER_OF_EDGES) ? Cube::Cubie(p[0], p[1]).string() : Cube::Cubie(p[1], p[0]).string();
+		}
 
-			size_t d = n.second + 1;
+		//Corners are the name rotated left by the orientation
+		const char *p = Cube::CORNER_POSITIONS[state % Cube::NUMBER_OF_CORNERS];
+		size_t o = state / Cube::NUMBER_OF_CORNERS;
+		return Cube::Cubie(p[o], p[(o + 1) % 3], p[(o + 2) % 3]).string();
+	}
 
-			for (const Search::Edge<CubeNode> &c : n.first.expand())
+	//Finds the state with the given face letters, returning false if there is none
+	bool parseManhattanState(const std::string &s, uint8_t &state, bool &corner)
+	{
+		corner = s.size() == 3;
+		for (uint8_t i = 0; i < ManhattanTable::STATES; i++)
+			if (manhattanStateString(i, corner) == s)
 			{
-				//Only consider new children
-				if (closed.find(c.first) == closed.end())
-				{
-					if (found.find(c.first.cube.cubies[i]) == found.end())
-					{
-						found.insert(c.first.cube.cubies[i]);
-
-						os << GOAL_CUBE.cubies[i].string() <<
-							"," << c.first.cube.cubies[i].string() <<
-							"," << d << std::endl;
-					}
-
-					open.push_back({ c.first, d });
-				}
+				state = i;
+				return true;
 			}
-		}
+
+		return false;
 	}
 }
 
-ManhattanMap loadManhattanTable(std::istream &is)
+void generateManhattanTable(std::ostream &os)
+{
+	ManhattanTable table;
+
+	//Distances of each piece from its goal state, edges then corners
+	for (size_t i = 0; i < Cube::NUMBER_OF_EDGES; i++)
+		for (size_t j = 0; j < ManhattanTable::STATES; j++)
+			if (j != i)
+				os << manhattanStateString(i, false) << "," << manhattanStateString(j, false) <<
+					"," << size_t(table.edges[i][j]) << std::endl;
+
+	for (size_t i = 0; i < Cube::NUMBER_OF_CORNERS; i++)
+		for (size_t j = 0; j < ManhattanTable::STATES; j++)
+			if (j != i)
+				os << manhattanStateString(i, true) << "," << manhattanStateString(j, true) <<
+					"," << size_t(table.corners[i][j]) << std::endl;
+}
+
+ManhattanTable loadManhattanTable(std::istream &is)
 {
-	ManhattanMap m;
+	//Start from the generated distances, so that files listing only edges still give corners
+	ManhattanTable table;
 	std::string sa, sb, val;
 
 	while (std::getline(is, sa, ','))
 	{
 		std::getline(is, sb, ',');
 		std::getline(is, val);
-		size_t v = std::stoi(val);
-		m[sa][sb] = v;
-	}
-
-	return m;
-}
-
-size_t lookupManhattanTable(const Cube::Cubie &a, const Cube::Cubie &b, ManhattanMap &m)
-{
-	std::string ca(a.string()), cb(b.string());
 
-	if (ca == cb) return 0;
+		uint8_t a, b;
+		bool cornerA, cornerB;
+		if (!parseManhattanState(sa, a, cornerA) || !parseManhattanState(sb, b, cornerB) || cornerA != cornerB)
+			throw std::ios_base::failure("Invalid Manhattan table entry " + sa + "," + sb);
 
-	//If the cubie isn't to be found, its reverse should be
-	if (m.find(ca) == m.end())
-	{
-		std::reverse(ca.begin(), ca.end());
-		std::reverse(cb.begin(), cb.end());
+		(cornerA ? table.corners : table.edges)[a][b] = uint8_t(std::stoi(val));
 	}
 
-	return m[ca][cb];
+	return table;
 }
 
 PatternDatabase loadPatternDatabase(std::istream &is, size_t n)
 {
-	PatternDatabase pd(n / 2);
+	std::vector<FourBitIntPair> pd(n / 2);
 	is.read(reinterpret_cast<char*>(&pd[0]), sizeof(pd[0]) * pd.size());
 
-	return pd;
+	if (size_t(is.gcount()) != sizeof(pd[0]) * pd.size())
+		throw std::ios_base::failure("Pattern database truncated");
+
+	return PatternDatabase(std::move(pd));
 }
 
-std::vector<uint8_t> enumerateCornerConfig(const Cube &cube)
+CornerConfig enumerateCornerConfig(const Cube &cube)
 {
-	//Enumeration 0-7 of goal corner pieces
-	static std::vector<std::string> pieces { GOAL_CUBE.cubies[12].string(),
-		GOAL_CUBE.cubies[13].string(), GOAL_CUBE.cubies[14].string(),
-		GOAL_CUBE.cubies[15].string(), GOAL_CUBE.cubies[16].string(), 
-		GOAL_CUBE.cubies[17].string(), GOAL_CUBE.cubies[18].string(), 
-		GOAL_CUBE.cubies[19].string() };
-
-	//Look up above numeration by string
-	auto lookupEnum = [](const std::string &s) -> uint8_t {
-		for (uint8_t i = 0; i < pieces.size(); i++)
-			if (std::is_permutation(s.begin(), s.end(), pieces[i].begin()))
-				return i;
-		return 0;
-	};
-
-	std::vector<uint8_t> result(15);
+	CornerConfig result;
 
+	//Each cubie byte holds the position the piece occupies and its orientation there
 	for (size_t i = 0; i < 8; i++)
-	{
-		//Get cubie string
-		std::string cubie = cube.cubies[12 + i].string();
-
-		//Log piece position
-		result[i] = lookupEnum(cubie);
-
-		if (i < 7)
-		{
-			//Log piece orientation (having defaulted to 0)
-			const std::string &goalCubie = pieces[result[i]];
-			if (cubie != goalCubie)
-			{
-				std::string nextOrientation = goalCubie.substr(1, 2) + goalCubie[0];
-				result[i + 8] = (cubie == nextOrientation) ? 1 : 2;
-			}
-		}
-	}
+		result[i] = cube.corners[i] & 15;
+	for (size_t i = 0; i < 7; i++)
+		result[i + 8] = cube.corners[i] >> 4;
 
 	return result;
 }
 
-size_t getCornerConfigIndex(const std::vector<uint8_t> &config)
+size_t getCornerConfigIndex(const CornerConfig &config)
 {
-	size_t index = 0;
-	size_t n = 88179840;
-	size_t p = 8;
-
-	bool indices[8];
-	for (size_t i = 0; i < 8; i++)
-		indices[i] = true;
-
-	//For each digit, bar the last
-	while (p > 1)
-	{
-		//Count 1s in the array before this digit
-		size_t c = 0;
-		for (size_t i = 0; i < config[8 - p]; i++)
-			if (indices[i])
-				c++;
-
-		//Update index
-		indices[config[8 - p]] = false;
-		n /= p;
-		p--;
-		index += c * n;
-	}
-
-	//Adjust to orientiation index
-	std::string base3;
-	for (size_t i = 8; i < 15; i++)
-		base3 += config[i] + '0';
-
-	index += std::stoi(base3, nullptr, 3);
-
-	return index;
+	//Lehmer rank of the 8 positions, then the first 7 orientations in base 3
+	return rankPositions(&config[0], 8, 8) * 2187 + rankDigits(&config[8], 7, 3);
 }
 
-void generateCornerPatternDatabase(std::ostream &os)
+namespace
 {
 	//As possible values range from 0-11, use this as null value
 	const uint8_t FOURBIT_NULL_VALUE = 15;
 
-	//Initialise table to 88,179,840 4-bit integers
-	PatternDatabase table(44089920, FourBitIntPair(FOURBIT_NULL_VALUE, FOURBIT_NULL_VALUE));
+	//Sets the given 4-bit entry of a table of packed pairs, unless already set
+	bool claimEntry(std::atomic<uint8_t> *table, size_t index, uint8_t value)
+	{
+		std::atomic<uint8_t> &pair = table[index / 2];
+		unsigned shift = (index % 2 == 0) ? 4 : 0;
 
-	std::deque<std::pair<CubeNode, uint8_t>> open;
-	open.push_back({ GOAL_CUBE_NODE, 0 });
+		uint8_t x = pair.load(std::memory_order_relaxed);
+		do
+		{
+			if ((x >> shift & 15) != FOURBIT_NULL_VALUE)
+				return false;
+		}
+		while (!pair.compare_exchange_weak(x, uint8_t((x & ~(15 << shift)) | value << shift), std::memory_order_relaxed));
 
-	//Counter of found states
-	size_t found = 0;
+		return true;
+	}
 
-	//Goal state yields zero
-	table[0].aSet(0);
-	found++;
+	//Returns the given 4-bit entry of a table of packed pairs
+	uint8_t entryValue(const std::atomic<uint8_t> *table, size_t index)
+	{
+		uint8_t x = table[index / 2].load(std::memory_order_relaxed);
+		return (index % 2 == 0) ? x >> 4 : x & 15;
+	}
 
-	while (!open.empty() && found < 88179840)
+	/* Generates a pattern database of n entries by breadth-first search
+		over indices from the goal index, given the index reached from each
+		by each move. No frontier is kept: each depth is found by scanning
+		the table itself, forwards from the entries at the previous depth
+		until half the table is set, then backwards from the unset entries
+		(moves being closed under inverse). Each scan is split across the
+		given number of threads, which claim entries by compare-and-swap;
+		the table holds the same depths whichever thread reaches an entry
+		first. The table is then written to the given stream. */
+	template <typename Twist>
+	void generatePatternDatabase(std::ostream &os, size_t n, size_t goal, Twist twist, size_t threads)
 	{
-		std::pair<CubeNode, uint8_t> n = open.front();
-		open.pop_front();
+		if (threads == 0)
+			threads = 1;
+
+		//Initialise table to n null 4-bit integers
+		std::unique_ptr<std::atomic<uint8_t>[]> table(new std::atomic<uint8_t>[n / 2]);
+		std::atomic<uint8_t> *entries = table.get();
+		for (size_t i = 0; i < n / 2; i++)
+			entries[i].store(FourBitIntPair(FOURBIT_NULL_VALUE, FOURBIT_NULL_VALUE).x, std::memory_order_relaxed);
+
+		//Goal state yields zero
+		claimEntry(entries, goal, 0);
 
-		uint8_t d = n.second + 1;
+		//Counter of found states, in total and by each thread at the next depth
+		size_t found = 1;
+		std::vector<size_t> reached(threads);
 
-		for (const Search::Edge<CubeNode> &c : n.first.expand())
+		for (uint8_t d = 0; found < n; d++)
 		{
-			//Only consider new children (in terms of considered config)
-			size_t index = getCornerConfigIndex(
-				enumerateCornerConfig(c.first.cube)
-			);
+			bool backward = found * 2 > n;
 
-			if ( (index % 2 == 0 ? table[index / 2].a() : table[index / 2].b()) == FOURBIT_NULL_VALUE)
+			auto worker = [&](size_t id)
 			{
-				if (index % 2 == 0)
-					table[index / 2].aSet(d);
-				else
-					table[index / 2].bSet(d);
+				reached[id] = 0;
 
-				open.push_back({ c.first, d });
-				found++;
-			}
+				//Ranges start on even indices, so that each byte is scanned by one thread
+				size_t begin = n * id / threads & ~size_t(1), end = (id + 1 == threads) ? n : n * (id + 1) / threads & ~size_t(1);
+				for (size_t i = begin; i < end; i++)
+				{
+					uint8_t v = entryValue(entries, i);
+
+					//Set the new children of entries at this depth
+					if (!backward && v == d)
+					{
+						for (size_t m = 0; m < Cube::NUMBER_OF_MOVES; m++)
+							if (claimEntry(entries, twist(i, Cube::Move(m)), d + 1))
+								reached[id]++;
+					}
+
+					//Set unset entries with a parent at this depth
+					else if (backward && v == FOURBIT_NULL_VALUE)
+					{
+						for (size_t m = 0; m < Cube::NUMBER_OF_MOVES; m++)
+							if (entryValue(entries, twist(i, Cube::Move(m))) == d)
+							{
+								claimEntry(entries, i, d + 1);
+								reached[id]++;
+								break;
+							}
+					}
+				}
+			};
+
+			std::vector<std::thread> pool;
+			for (size_t i = 1; i < threads; i++)
+				pool.emplace_back(worker, i);
+			worker(0);
+			for (std::thread &t : pool)
+				t.join();
+
+			//Stop if the rest of the table is unreachable
+			size_t count = 0;
+			for (size_t c : reached)
+				count += c;
+			if (count == 0)
+				break;
+
+			found += count;
+		}
+
+		//Write out through a small buffer, rather than a second copy of the table
+		std::vector<char> buffer(std::min<size_t>(n / 2, size_t(1) << 20));
+		for (size_t i = 0; i < n / 2; i += buffer.size())
+		{
+			size_t length = std::min(buffer.size(), n / 2 - i);
+			for (size_t j = 0; j < length; j++)
+				buffer[j] = char(entries[i + j].load(std::memory_order_relaxed));
+			os.write(buffer.data(), length);
 		}
 	}
+}
+
+void generateCornerPatternDatabase(std::ostream &os, size_t threads)
+{
+	const CoordinateTables &tables = CoordinateTables::get();
 
-	os.write(reinterpret_cast<const char*>(&table[0]), sizeof(table[0]) * table.size());
+	//Search over indices alone, starting from the goal
+	generatePatternDatabase(os, 88179840, CubeIndices(GOAL_CUBE).corner,
+		[&tables](size_t index, Cube::Move m) { return tables.twistCorner(index, m); }, threads);
 }
 
-std::vector<uint8_t> enumerateEdgeConfig(const Cube &cube, int set)
+EdgeConfig enumerateEdgeConfig(const Cube &cube, int set)
 {
 	if (set != 1 && set != 2)
 		throw std::invalid_argument("Edge set must be 1 or 2");
 
-	////Enumeration 0-5 of goal edge pieces (set 1)
-	//static std::vector<std::string> pieces1 { GOAL_CUBE.cubies[0].string(),
-	//	GOAL_CUBE.cubies[1].string(), GOAL_CUBE.cubies[2].string(),
-	//	GOAL_CUBE.cubies[3].string(), GOAL_CUBE.cubies[4].string(),
-	//	GOAL_CUBE.cubies[5].string() };
-
-	////Enumeration 0-5 of goal edge pieces (set 2)
-	//static std::vector<std::string> pieces2 { GOAL_CUBE.cubies[6].string(),
-	//	GOAL_CUBE.cubies[7].string(), GOAL_CUBE.cubies[8].string(),
-	//	GOAL_CUBE.cubies[9].string(), GOAL_CUBE.cubies[10].string(),
-	//	GOAL_CUBE.cubies[11].string() };
-
-	//const std::vector<std::string> &pieces = (set == 1) ? pieces1 : pieces2;
-
-	//Enumeration 0-11 of goal edge pieces
-	static std::vector<std::string> pieces { GOAL_CUBE.cubies[0].string(),
-		GOAL_CUBE.cubies[1].string(), GOAL_CUBE.cubies[2].string(),
-		GOAL_CUBE.cubies[3].string(), GOAL_CUBE.cubies[4].string(),
-		GOAL_CUBE.cubies[5].string(), GOAL_CUBE.cubies[6].string(),
-		GOAL_CUBE.cubies[7].string(), GOAL_CUBE.cubies[8].string(),
-		GOAL_CUBE.cubies[9].string(), GOAL_CUBE.cubies[10].string(),
-		GOAL_CUBE.cubies[11].string() };
-
-	//Look up above numeration by string
-	auto lookupEnum = [](const std::string &s) -> uint8_t {
-		for (uint8_t i = 0; i < pieces.size(); i++)
-			if (std::is_permutation(s.begin(), s.end(), pieces[i].begin()))
-				return i;
-		return 0;
-	};
-
-	std::vector<uint8_t> result(12);
-
-	for (size_t i = 0; i < 6; i++)
-	{
-		//Get cubie string
-		std::string cubie = cube.cubies[(set == 1) ? i : 6 + i].string();
+	if (set == 1)
+		return enumerateEdgeConfig(cube, EDGE_SET);
 
-		//Log piece position
-		result[i] = lookupEnum(cubie);
+	//The second set is the first in the conjugated state, of which only those pieces are needed
+	const Symmetry &s = edgeSetSymmetry();
+	EdgeConfig result;
+	result.k = EDGE_SET.size();
 
-		//Log piece orientation (having defaulted to 0)
-		if (cubie != pieces[result[i]])
-			result[i + 6] = 1;
+	for (size_t i = 0; i < result.k; i++)
+	{
+		uint8_t x = s.conjugateEdge(cube, EDGE_SET[i]);
+		result.values[i] = x & 15;
+		result.values[i + result.k] = x >> 4;
 	}
 
 	return result;
 }
 
-size_t getEdgeConfigIndex(const std::vector<uint8_t> &config)
+EdgeConfig enumerateEdgeConfig(const Cube &cube, const std::vector<uint8_t> &selection)
 {
-	size_t index = 0;
-	size_t n = 42577920;
-	size_t p = 6;
-	size_t q = 12;
-
-	bool indices[12];
-	for (size_t i = 0; i < 12; i++)
-		indices[i] = true;
+	EdgeConfig result;
+	result.k = selection.size();
 
-	//For each digit, including the last
-	while (p > 0)
+	//Each cubie byte holds the position the piece occupies and whether it is flipped there
+	for (size_t i = 0; i < result.k; i++)
 	{
-		//Count 1s in the array before this digit
-		size_t c = 0;
-		for (size_t i = 0; i < config[6 - p]; i++)
-			if (indices[i])
-				c++;
-
-		//Update index
-		indices[config[6 - p]] = false;
-		n /= q;
-		p--; q--;
-		index += c * n;
+		result.values[i] = cube.edges[selection[i]] & 15;
+		result.values[i + result.k] = cube.edges[selection[i]] >> 4;
 	}
 
-	//Adjust to orientation index
-	std::string base2;
-	for (size_t i = 6; i < 12; i++)
-		base2 += config[i] + '0';
-
-	index += std::stoi(base2, nullptr, 2);
-
-	return index;
+	return result;
 }
 
-void generateEdgePatternDatabase(std::ostream &os, int set)
+size_t getEdgeConfigIndex(const EdgeConfig &config)
 {
-	if (set != 1 && set != 2)
-		throw std::invalid_argument("Edge set must be 1 or 2");
-
-	//As possible values range from 0-10, use this as null value
-	const uint8_t FOURBIT_NULL_VALUE = 15;
-
-	//Initialise table to 42,577,920 4-bit integers
-	PatternDatabase table(21288960, FourBitIntPair(FOURBIT_NULL_VALUE, FOURBIT_NULL_VALUE));
+	size_t k = config.k;
 
-	std::deque<std::pair<CubeNode, uint8_t>> open;
-	open.push_back({ GOAL_CUBE_NODE, 0 });
-
-	//Counter of found states
-	size_t found = 0;
-
-	//Goal state yields zero
-	table[0].aSet(0);
-	found++;
+	//Lehmer rank of the k positions out of 12, then the flips in base 2
+	return (rankPositions(&config.values[0], k, 12) << k) + rankDigits(&config.values[k], k, 2);
+}
 
-	while (!open.empty() && found < 42577920)
-	{
-		std::pair<CubeNode, uint8_t> n = open.front();
-		open.pop_front();
+size_t edgePatternDatabaseSize(size_t k)
+{
+	//Arrangements of k positions out of 12, times 2^k flips
+	return arrangements(12, k) << k;
+}
 
-		uint8_t d = n.second + 1;
+void generateEdgePatternDatabase(std::ostream &os, const std::vector<uint8_t> &pieces, size_t threads)
+{
+	EdgeMoveTable table(pieces.size());
 
-		for (const Search::Edge<CubeNode> &c : n.first.expand())
-		{
-			//Only consider new children (in terms of considered config)
-			size_t index = getEdgeConfigIndex(
-				enumerateEdgeConfig(c.first.cube, set)
-			);
+	//Search over indices alone, starting from the goal
+	size_t goal = getEdgeConfigIndex(enumerateEdgeConfig(GOAL_CUBE, pieces));
+	generatePatternDatabase(os, edgePatternDatabaseSize(pieces.size()), goal,
+		[&table](size_t index, Cube::Move m) { return table.twist(index, m); }, threads);
+}
 
-			if ( (index % 2 == 0 ? table[index / 2].a() : table[index / 2].b()) == FOURBIT_NULL_VALUE)
-			{
-				if (index % 2 == 0)
-					table[index / 2].aSet(d);
-				else
-					table[index / 2].bSet(d);
+void generateReducedPatternDatabase(std::ostream &os, const SymmetryReduction &reduction, size_t threads)
+{
+	//Search over the classes, each standing for all its members
+	generatePatternDatabase(os, reduction.size(), reduction.index(GOAL_CUBE),
+		[&reduction](size_t index, Cube::Move m) { return reduction.twist(index, m); }, threads);
+}
 
-				open.push_back({ c.first,d });
-				found++;
-			}
-		}
-	}
+ModThreePatternDatabaseHeuristic::Track ModThreePatternDatabaseHeuristic::track(const CubeNode &n) const
+{
+	static const CubeIndices goal(GOAL_CUBE);
 
-	std::cout << "found: " << found << std::endl;
+	auto cornerIndex = [](const Cube &cube) { return getCornerConfigIndex(enumerateCornerConfig(cube)); };
+	auto edge1Index = [](const Cube &cube) { return getEdgeConfigIndex(enumerateEdgeConfig(cube, 1)); };
+	auto edge2Index = [](const Cube &cube) { return getEdgeConfigIndex(enumerateEdgeConfig(cube, 2)); };
 
-	os.write(reinterpret_cast<const char*>(&table[0]), sizeof(table[0]) * table.size());
+	//Descend each database to its goal
+	return { corner.value(n.cube, goal.corner, cornerIndex), edge.value(n.cube, goal.edge1, edge1Index),
+		edge.value(n.cube, goal.edge2, edge2Index) };
 }
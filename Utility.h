@@ -9,7 +9,13 @@
 #pragma once
 
 #include "CubeNode.h"
-#include "FourBitIntPair.h"
+#include "Coordinates.h"
+#include "PatternDatabase.h"
+#include "ModThreePatternDatabase.h"
+#include "ManhattanTable.h"
+#include "SymmetryReduction.h"
+
+#include <array>
 
 //Defines the Cube goal states
 const Cube GOAL_CUBE("UF UR UB UL DF DR DB DL FR FL BR BL UFR URB UBL ULF DRF DFL DLB DBR");
@@ -20,44 +26,371 @@ const CubeNode GOAL_CUBE_NODE(GOAL_CUBE);
 Cube generateCubeProblem(size_t depth, bool print = false);
 
 
-//Internal map format of the Manhattan distance function
-using ManhattanMap = std::unordered_map<std::string, std::unordered_map<std::string, size_t>>;
-
-//Generates the edge piece Manhattan lookup CSV to the given stream
+//Generates the edge and corner piece Manhattan lookup CSV to the given stream
 void generateManhattanTable(std::ostream &os);
 
-//Loads a ManhattanMap from the given stream
-ManhattanMap loadManhattanTable(std::istream &is);
+//Loads a ManhattanTable from the given stream
+ManhattanTable loadManhattanTable(std::istream &is);
 
-//Looks up the Manhattan distance between the given edge cubies
-size_t lookupManhattanTable(const Cube::Cubie &a, const Cube::Cubie &b, ManhattanMap &m);
 
+//Loads a PatternDatabase of n values from the given stream into memory
+//(see PatternDatabase::map to share a file between processes instead)
+PatternDatabase loadPatternDatabase(std::istream &is, size_t n);
 
-//Internal map format of the pattern database
-using PatternDatabase = std::vector<FourBitIntPair>;
 
-//Loads a PatternDatabase from the given stream
-PatternDatabase loadPatternDatabase(std::istream &is, size_t n);
+//Corner piece configuration: the position of each goal corner piece 0-7,
+//then the orientation of pieces 0-6 (the last follows from the others)
+using CornerConfig = std::array<uint8_t, 15>;
 
+//Edge piece configuration: the position of each of k selected goal edge
+//pieces, then the flip of each
+struct EdgeConfig
+{
+	size_t k;
+	std::array<uint8_t, 16> values;
+
+	uint8_t operator[](size_t i) const { return values[i]; }
+};
 
 //Enumerates the corner piece configuration of the given Cube
-std::vector<uint8_t> enumerateCornerConfig(const Cube &cube);
+CornerConfig enumerateCornerConfig(const Cube &cube);
 
 //Converts a corner piece enumeration into database index
-size_t getCornerConfigIndex(const std::vector<uint8_t> &config);
+size_t getCornerConfigIndex(const CornerConfig &config);
+
+//Generates the corner piece pattern database to the given stream, using the given number of threads
+void generateCornerPatternDatabase(std::ostream &os, size_t threads = 1);
+
 
-//Generates the corner piece pattern database to the given stream
-void generateCornerPatternDatabase(std::ostream &os);
+//Edge pieces of the default edge pattern database
+const std::vector<uint8_t> EDGE_SET { 0, 1, 2, 3, 8, 9 };
 
+//Enumerates the edge piece configuration of the given Cube: set 1 is the default edge
+//set, and set 2 the other six edges, carried onto it by symmetry (see edgeSetSymmetry)
+EdgeConfig enumerateEdgeConfig(const Cube &cube, int set);
 
-//Enumerates the edge piece configuration of the given Cube (set 1 or 2)
-std::vector<uint8_t> enumerateEdgeConfig(const Cube &cube, int set);
+//Enumerates the configuration of the given edge pieces (0-11, at most 8 of them)
+EdgeConfig enumerateEdgeConfig(const Cube &cube, const std::vector<uint8_t> &selection);
+
+//Converts an edge piece enumeration (of any selection) into database index
+size_t getEdgeConfigIndex(const EdgeConfig &config);
+
+//Number of values in the pattern database of k edge pieces
+size_t edgePatternDatabaseSize(size_t k);
+
+//Generates the pattern database of the given edge pieces to the given stream, using the given number of threads
+void generateEdgePatternDatabase(std::ostream &os, const std::vector<uint8_t> &pieces, size_t threads = 1);
+
+//Generates the symmetry-reduced pattern database of the given reduction's pieces to the given stream,
+//using the given number of threads
+void generateReducedPatternDatabase(std::ostream &os, const SymmetryReduction &reduction, size_t threads = 1);
+
+
+//Looks up the value stored at the given index of a pattern database
+inline uint8_t lookupPatternDatabase(const PatternDatabase &pd, size_t i)
+{
+	return (i % 2 == 0) ? pd[i / 2].a() : pd[i / 2].b();
+}
+
+//Hints that the value at the given index of a pattern database is about to be read
+inline void prefetchPatternDatabase(const PatternDatabase &pd, size_t i)
+{
+	pd.prefetch(i / 2);
+}
+
+//Heuristic policy taking the max of the corner and both edge set lookups, the edge database
+//serving both sets; probes a batch of nodes before reading any (see Search::HeuristicBatch)
+struct PatternDatabaseHeuristic
+{
+	const PatternDatabase &corner, &edge;
+
+	//Database indices of a node
+	struct Probe
+	{
+		size_t corner, edge1, edge2;
+	};
+
+	Probe probe(const CubeNode &n) const
+	{
+		Probe p{ getCornerConfigIndex(enumerateCornerConfig(n.cube)),
+			getEdgeConfigIndex(enumerateEdgeConfig(n.cube, 1)), getEdgeConfigIndex(enumerateEdgeConfig(n.cube, 2)) };
+
+		prefetchPatternDatabase(corner, p.corner);
+		prefetchPatternDatabase(edge, p.edge1);
+		prefetchPatternDatabase(edge, p.edge2);
+		return p;
+	}
+
+	uint8_t operator()(const Probe &p) const
+	{
+		return std::max({ lookupPatternDatabase(corner, p.corner), lookupPatternDatabase(edge, p.edge1),
+			lookupPatternDatabase(edge, p.edge2) });
+	}
+
+	uint8_t operator()(const CubeNode &n) const
+	{
+		uint8_t c = lookupPatternDatabase(corner, getCornerConfigIndex(enumerateCornerConfig(n.cube)));
+		uint8_t e1 = lookupPatternDatabase(edge, getEdgeConfigIndex(enumerateEdgeConfig(n.cube, 1)));
+		uint8_t e2 = lookupPatternDatabase(edge, getEdgeConfigIndex(enumerateEdgeConfig(n.cube, 2)));
+
+		return std::max({ c, e1, e2 });
+	}
+};
+
+//An edge piece pattern database, with the pieces it covers
+struct EdgePatternDatabase
+{
+	std::vector<uint8_t> pieces;
+	PatternDatabase pd;
+};
+
+//Largest number of edge pattern databases used at once
+const size_t MAX_EDGE_PATTERN_DATABASES = 12;
+
+//Heuristic policy taking the max of the corner and any edge pattern database lookups,
+//probing a batch of nodes before reading any (see Search::HeuristicBatch)
+struct EdgePatternDatabasesHeuristic
+{
+	const PatternDatabase &corner;
+	const std::vector<EdgePatternDatabase> &edges;
+
+	//Database indices of a node, the corner's then each edge database's
+	struct Probe
+	{
+		size_t corner;
+		size_t edges[MAX_EDGE_PATTERN_DATABASES];
+	};
+
+	Probe probe(const CubeNode &n) const
+	{
+		Probe p;
+		p.corner = getCornerConfigIndex(enumerateCornerConfig(n.cube));
+		prefetchPatternDatabase(corner, p.corner);
+
+		for (size_t i = 0; i < edges.size(); i++)
+		{
+			p.edges[i] = getEdgeConfigIndex(enumerateEdgeConfig(n.cube, edges[i].pieces));
+			prefetchPatternDatabase(edges[i].pd, p.edges[i]);
+		}
+
+		return p;
+	}
+
+	uint8_t operator()(const Probe &p) const
+	{
+		uint8_t h = lookupPatternDatabase(corner, p.corner);
+		for (size_t i = 0; i < edges.size(); i++)
+			h = std::max(h, lookupPatternDatabase(edges[i].pd, p.edges[i]));
+
+		return h;
+	}
+
+	uint8_t operator()(const CubeNode &n) const
+	{
+		uint8_t h = lookupPatternDatabase(corner, getCornerConfigIndex(enumerateCornerConfig(n.cube)));
+		for (const EdgePatternDatabase &e : edges)
+			h = std::max(h, lookupPatternDatabase(e.pd, getEdgeConfigIndex(enumerateEdgeConfig(n.cube, e.pieces))));
+
+		return h;
+	}
+};
+
+
+/* A lookup in a symmetry-reduced pattern database, with the reduction
+	indexing it. If a view is given, the database is read in the state
+	seen through it, giving the value of the piece set that symmetry
+	carries onto the database's own. */
+struct ReducedPatternDatabase
+{
+	const SymmetryReduction &reduction;
+	const PatternDatabase &pd;
+	const Symmetry *view;
+
+	//Returns the Cube as the database sees it
+	Cube seen(const Cube &cube) const { return view ? reduction.view(cube, *view) : cube; }
+};
+
+//Heuristic policy taking the max over symmetry-reduced pattern database lookups (the
+//corners' and any edge sets'), probing a batch of nodes before reading any: first
+//each class table, then each database
+struct ReducedPatternDatabasesHeuristic
+{
+	const std::vector<ReducedPatternDatabase> &databases;
+
+	//Arrangement ranks of a node, refined into database indices
+	struct Probe
+	{
+		const Cube *cube;
+		size_t indices[MAX_EDGE_PATTERN_DATABASES + 1];
+	};
+
+	Probe probe(const CubeNode &n) const
+	{
+		Probe p;
+		p.cube = &n.cube;
+
+		for (size_t i = 0; i < databases.size(); i++)
+		{
+			const ReducedPatternDatabase &d = databases[i];
+			p.indices[i] = d.reduction.arrangement(d.seen(n.cube));
+			d.reduction.prefetch(p.indices[i]);
+		}
+
+		return p;
+	}
+
+	void refine(Probe &p) const
+	{
+		for (size_t i = 0; i < databases.size(); i++)
+		{
+			const ReducedPatternDatabase &d = databases[i];
+			p.indices[i] = d.reduction.index(d.seen(*p.cube), p.indices[i]);
+			prefetchPatternDatabase(d.pd, p.indices[i]);
+		}
+	}
+
+	uint8_t operator()(const Probe &p) const
+	{
+		uint8_t h = 0;
+		for (size_t i = 0; i < databases.size(); i++)
+			h = std::max(h, lookupPatternDatabase(databases[i].pd, p.indices[i]));
+
+		return h;
+	}
+
+	uint8_t operator()(const CubeNode &n) const
+	{
+		uint8_t h = 0;
+		for (const ReducedPatternDatabase &d : databases)
+			h = std::max(h, lookupPatternDatabase(d.pd, d.reduction.index(d.seen(n.cube))));
+
+		return h;
+	}
+};
+
+/* Heuristic policy taking the max of the corner and both edge set values,
+	held modulo 3, tracking them along the search path. Each child's
+	indices are enumerated from its Cube, and their entries prefetched
+	for all the children of a node before any is read. */
+struct ModThreePatternDatabaseHeuristic
+{
+	const ModThreePatternDatabase &corner, &edge;
+
+	//Database values of a node
+	struct Track
+	{
+		uint8_t corner, edge1, edge2;
+	};
+
+	//Recovers the values of a node from scratch
+	Track track(const CubeNode &n) const;
+
+	//Follows the values of a child on from its parent's
+	Track track(const Track &parent, const CubeNode &child, Search::Operation /*op*/) const
+	{
+		CubeIndices i(child.cube);
+		return { corner.value(i.corner, parent.corner), edge.value(i.edge1, parent.edge1),
+			edge.value(i.edge2, parent.edge2) };
+	}
+
+	//Follows the values of all the children of a node on from its own
+	void track(const Track &parent, const CubeNode *children, const Search::Operation* /*ops*/, size_t count,
+		Track *tracks, size_t /*bound*/) const
+	{
+		CubeIndices indices[CubeNode::OPERATIONS];
+		for (size_t i = 0; i < count; i++)
+		{
+			indices[i] = CubeIndices(children[i].cube);
+			corner.prefetch(indices[i].corner);
+			edge.prefetch(indices[i].edge1);
+			edge.prefetch(indices[i].edge2);
+		}
+
+		for (size_t i = 0; i < count; i++)
+			tracks[i] = { corner.value(indices[i].corner, parent.corner), edge.value(indices[i].edge1, parent.edge1),
+				edge.value(indices[i].edge2, parent.edge2) };
+	}
+
+	size_t cost(const Track &t) const { return std::max({ t.corner, t.edge1, t.edge2 }); }
+
+	uint8_t operator()(const CubeNode &n) const { return uint8_t(cost(track(n))); }
+};
+
+/* Heuristic policy taking the greater of the edge and corner piece Manhattan
+	distance sums, divided by 4 (rounded up): a face turn moves 4 of each */
+struct ManhattanHeuristic
+{
+	const ManhattanTable &m;
+
+	uint8_t operator()(const CubeNode &n) const
+	{
+		ManhattanTable::Sums s = m.sum(n.cube);
+		return uint8_t((std::max(s.edges, s.corners) + 3) / 4);
+	}
+};
+
+/* Heuristic policy taking the greater of another policy's values for a
+	node and for its inverse, which lies as far from the goal but often
+	scores higher. The inverse is tracked along the search path: a
+	child's inverse is its parent's with the inverse move applied first.
+	A node's children are evaluated as a batch (see Search::HeuristicBatch),
+	then the inverses of those whose own values could still be expanded or
+	set the next threshold. */
+template <typename Heuristic>
+struct DualHeuristic
+{
+	using Value = typename Search::HeuristicBatch<CubeNode, Heuristic>::Value;
+
+	Heuristic h;
+
+	//Inverse of a node, and the node's value
+	struct Track
+	{
+		Cube inverse;
+		Value value;
+	};
+
+	Track track(const CubeNode &n) const
+	{
+		Cube inverse = n.cube.inverse();
+		return { inverse, std::max(h(n), h(CubeNode(inverse))) };
+	}
+
+	Track track(const Track &parent, const CubeNode &child, Search::Operation op) const
+	{
+		Cube inverse = Cube::MOVES[Cube::inverse(Cube::Move(op))].apply(parent.inverse);
+		return { inverse, std::max(h(child), h(CubeNode(inverse))) };
+	}
+
+	void track(const Track &parent, const CubeNode *children, const Search::Operation *ops, size_t count, Track *tracks,
+		size_t bound) const
+	{
+		Search::HeuristicBatch<CubeNode, Heuristic> batch{ h };
+		Value values[CubeNode::OPERATIONS], inverseValues[CubeNode::OPERATIONS];
+		batch.evaluate(children, count, values);
+
+		//Only the children left below the bound are worth looking up again
+		CubeNode inverses[CubeNode::OPERATIONS];
+		size_t open[CubeNode::OPERATIONS], n = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			tracks[i] = { Cube::MOVES[Cube::inverse(Cube::Move(ops[i]))].apply(parent.inverse), values[i] };
+			if (Search::wholeCost(values[i]) < bound)
+			{
+				inverses[n] = tracks[i].inverse;
+				open[n++] = i;
+			}
+		}
+
+		batch.evaluate(inverses, n, inverseValues);
+		for (size_t j = 0; j < n; j++)
+			tracks[open[j]].value = std::max(values[open[j]], inverseValues[j]);
+	}
 
-//Converts an edge piece enumeration into database index (set 1 or 2)
-size_t getEdgeConfigIndex(const std::vector<uint8_t> &config);
+	size_t cost(const Track &t) const { return Search::wholeCost(t.value); }
 
-//Generates the edge piece pattern database to the given stream (set 1 or 2)
-void generateEdgePatternDatabase(std::ostream &os, int set);
+	Value operator()(const CubeNode &n) const { return std::max(h(n), h(CubeNode(n.cube.inverse()))); }
+};
 
 
 //Computes the median of a given vector of elements
@@ -10,12 +10,15 @@
 
 #include "XGetopt.h"
 #include "Utility.h"
+#include "PatternDatabaseFile.h"
+#include "Benchmark.h"
 
 #include <iostream>
 #include <fstream>
 #include <chrono>
 #include <algorithm>
 #include <functional>
+#include <thread>
 
 //Ensures mutual exclusion of mode option flags
 bool validateMode()
@@ -52,6 +55,128 @@ bool validateAlg()
 }
 
 
+//Describes each pattern database, by its own file and within a container file
+struct PatternDatabaseSpec
+{
+	std::string file;
+	std::string description;
+	size_t n;
+
+	//Edge pieces covered (none for the corner database)
+	std::vector<uint8_t> edges;
+};
+
+//The corner and 6-edge pattern databases used by default, the edge
+//database serving the other six edges too (see edgeSetSymmetry)
+const std::vector<PatternDatabaseSpec> PATTERN_DATABASES {
+	{ "cornerpd.bin", "3x3x3 corners 0-7", 88179840, {} },
+	{ "edgepd_0_1_2_3_8_9.bin", "3x3x3 edges 0,1,2,3,8,9", 42577920, EDGE_SET }
+};
+
+//Files of the default pattern databases modulo 3 (see ModThreePatternDatabase), in the same order
+const std::vector<std::string> MOD_THREE_FILES { "cornerpd_mod3.bin", "edgepd_0_1_2_3_8_9_mod3.bin" };
+
+//Describes the pattern database of the given comma-separated edge pieces (0-11),
+//returning false unless 1-8 distinct pieces are given
+bool parseEdgePatternDatabase(const std::string &list, PatternDatabaseSpec &spec)
+{
+	std::vector<uint8_t> pieces;
+	std::string name;
+
+	size_t begin = 0;
+	while (begin <= list.size())
+	{
+		size_t end = std::min(list.find(',', begin), list.size());
+		size_t piece;
+		try { piece = std::stoul(list.substr(begin, end - begin)); }
+		catch (std::logic_error&) { return false; }
+
+		if (piece >= Cube::NUMBER_OF_EDGES || std::count(pieces.begin(), pieces.end(), piece) > 0)
+			return false;
+
+		pieces.push_back(uint8_t(piece));
+		name += (name.empty() ? "" : ",") + std::to_string(piece);
+		begin = end + 1;
+	}
+
+	if (pieces.size() > 8)
+		return false;
+
+	std::string fileName = name;
+	std::replace(fileName.begin(), fileName.end(), ',', '_');
+
+	spec = { "edgepd_" + fileName + ".bin", "3x3x3 edges " + name, edgePatternDatabaseSize(pieces.size()), pieces };
+	return true;
+}
+
+//Name of the container file bundling all pattern databases
+const char PATTERN_DATABASE_CONTAINER[] = "patterndatabases.pdb";
+
+
+//Heuristic search algorithms, bound to a heuristic once it is loaded
+enum HEURISTIC_SEARCH { IDA_STAR, PURE_HEURISTIC, A_STAR, PARALLEL_IDA_STAR };
+
+//Search subroutine signature
+using SearchFunc = std::function<Search::Path(const CubeNode&, const CubeNode&)>;
+
+//Settings of the heuristic searches, beyond their heuristic
+struct SearchSettings
+{
+	//Threads for parallel searches, and the depth at which they split each iteration into subtrees
+	size_t threads, splitDepth;
+
+	//Keep the nodes A* and pure heuristic search store by rank, in less memory but more time?
+	bool keyed;
+};
+
+//Node store keeping each Cube by its rank (see NodeStore)
+using KeyedStore = Search::NodeStore<CubeNode, true>;
+
+//Binds the given heuristic search to the given heuristic policy, so
+//that its lookups are inlined into the search loop
+template <typename Heuristic>
+void bindSearch(HEURISTIC_SEARCH alg, Heuristic h, const SearchSettings &settings, SearchFunc &executeSearch,
+	SearchFunc &serialSearch)
+{
+	size_t threads = settings.threads, splitDepth = settings.splitDepth;
+
+	switch (alg)
+	{
+	case IDA_STAR:
+		executeSearch = [h](const CubeNode &a, const CubeNode &b) { return Search::PrunedIDAstar(a, b, h); }; break;
+	case PURE_HEURISTIC:
+		if (settings.keyed)
+			executeSearch = [h](const CubeNode &a, const CubeNode &b) { return Search::PHS<CubeNode, Heuristic, KeyedStore>(a, b, h); };
+		else
+			executeSearch = [h](const CubeNode &a, const CubeNode &b) { return Search::PHS(a, b, h); };
+		break;
+	case A_STAR:
+		if (settings.keyed)
+			executeSearch = [h](const CubeNode &a, const CubeNode &b) { return Search::Astar<CubeNode, Heuristic, KeyedStore>(a, b, h); };
+		else
+			executeSearch = [h](const CubeNode &a, const CubeNode &b) { return Search::Astar(a, b, h); };
+		break;
+	case PARALLEL_IDA_STAR:
+		executeSearch = [h, threads, splitDepth](const CubeNode &a, const CubeNode &b) {
+			return Search::ParallelIDAstar(a, b, h, threads, splitDepth);
+		};
+		serialSearch = [h](const CubeNode &a, const CubeNode &b) { return Search::PrunedIDAstar(a, b, h); }; break;
+	}
+}
+
+//Binds the given heuristic search as above, to the greater of the given heuristic
+//policy's values for each node and its inverse if dual is set
+template <typename Heuristic>
+void bindSearch(HEURISTIC_SEARCH alg, Heuristic h, bool dual, const SearchSettings &settings, SearchFunc &executeSearch,
+	SearchFunc &serialSearch)
+{
+	if (dual)
+		bindSearch(alg, DualHeuristic<Heuristic>{ h }, settings, executeSearch, serialSearch);
+	else
+		bindSearch(alg, h, settings, executeSearch, serialSearch);
+}
+
+
 //Main entry point
 int main(int argc, char **argv)
 {
@@ -61,19 +186,52 @@ int main(int argc, char **argv)
 	//Depth flag
 	size_t depth = 0;
 
+	//Number of threads for parallel modes (default: all cores), and the most that may be asked for
+	size_t threads = std::max(1u, std::thread::hardware_concurrency());
+	const size_t MAX_THREADS = 4 * threads;
+
+	//Depth at which parallel IDA* splits each iteration (default: the 243 two-move prefixes), and the
+	//deepest allowed, below which the subtree roots alone (some 18 * 15^(n - 1)) would crowd memory
+	size_t splitDepth = 2;
+	const size_t MAX_SPLIT_DEPTH = 5;
+
 	//Will we require a search algorithm?
 	bool needAlg = true, needHeur = true;
 
-	//Subroutine encapsulating the heuristic function to use (default: pattern database)
-	std::function<double(const CubeNode&, const CubeNode&)> hFunc;
+	//Container file to load pattern databases from (default: map the separate files)
+	std::string pdContainer;
+
+	//Hold pattern databases modulo 3, in half the memory?
+	bool modThree = false;
+
+	//Copy pattern databases onto huge pages, and to every NUMA node?
+	bool hugePages = false, replicate = false;
+
+	//Use pattern databases reduced by the symmetries of the Cube?
+	bool symmetryReduced = false;
+
+	//Also look up the inverse of each state, taking the greater value?
+	bool dual = false;
+
+	//Keep the nodes of BFS, A* and pure heuristic search by rank?
+	bool keyed = false;
 
-	//Subroutine encapsulating the search algorithm to use (default: IDA*)
-	std::function<Search::Path(const CubeNode&, const CubeNode&)> executeSearch;
+	//Edge pattern databases to use in place of the default one
+	std::vector<PatternDatabaseSpec> edgePatterns;
+
+	//Heuristic search to use, unless an uninformed one is set (default: IDA*)
+	HEURISTIC_SEARCH heuristicSearch = IDA_STAR;
+
+	//Subroutine encapsulating the search algorithm to use
+	SearchFunc executeSearch;
+
+	//Single-threaded equivalent of a parallel search, for timing comparison
+	SearchFunc serialSearch;
 
 	//Get command line options
-	enum CMD_OPTIONS { GENERATE, GENERATE_ALL, MANHATTAN, PATTERN, TIME, MANHATTAN_USE };
-	bool opts[6] = { false };
-	char optstring[] = "g:GMPtbdipam";
+	enum CMD_OPTIONS { GENERATE, GENERATE_ALL, MANHATTAN, PATTERN, TIME, MANHATTAN_USE, BENCHMARK };
+	bool opts[7] = { false };
+	char optstring[] = "g:GMPtbdipacmj:l:f:re:BHNsuk";
 	int c;
 	bool success = true;
 	std::string algName = "ITERATIVE DEEPENING A*";
@@ -101,10 +259,15 @@ int main(int argc, char **argv)
 		case 't':
 			success &= validateMode();
 			opts[TIME] = true; break;
+		case 'B':
+			success &= validateMode();
+			opts[BENCHMARK] = true; needAlg = false; break;
 		case 'b':
 			success &= validateAlg();
 			algName = "BREADTH-FIRST SEARCH"; needHeur = false;
-			executeSearch = [](const CubeNode &a, const CubeNode &b) { return Search::BFS(a, b); }; break;
+			executeSearch = [&keyed](const CubeNode &a, const CubeNode &b) {
+				return keyed ? Search::BFS<CubeNode, KeyedStore>(a, b) : Search::BFS(a, b);
+			}; break;
 		case 'd':
 			success &= validateAlg();
 			algName = "DEPTH-FIRST SEARCH"; needHeur = false;
@@ -116,13 +279,67 @@ int main(int argc, char **argv)
 		case 'p':
 			success &= validateAlg();
 			algName = "PURE HEURISTIC SEARCH";
-			executeSearch = [&hFunc](const CubeNode &a, const CubeNode &b) { return Search::PHS(a, b, hFunc); }; break;
+			heuristicSearch = PURE_HEURISTIC; break;
 		case 'a':
 			success &= validateAlg();
 			algName = "A*";
-			executeSearch = [&hFunc](const CubeNode &a, const CubeNode &b) { return Search::Astar(a, b, hFunc); }; break;
+			heuristicSearch = A_STAR; break;
+		case 'c':
+			success &= validateAlg();
+			algName = "PARALLEL ITERATIVE DEEPENING A*";
+			heuristicSearch = PARALLEL_IDA_STAR; break;
 		case 'm':
 			opts[MANHATTAN_USE] = true; break;
+		case 'j':
+		{
+			//Parsed signed, so that negative counts are caught rather than wrapped
+			long count;
+			try { count = std::stol(optarg); }
+			catch (std::logic_error&) { count = 0; }
+			if (count < 1 || count > long(MAX_THREADS))
+			{
+				std::cerr << "Error: Valid thread count must be specified" << std::endl;
+				return EXIT_FAILURE;
+			}
+			threads = size_t(count);
+			break;
+		}
+		case 'l':
+		{
+			//Parsed signed, as the thread count is
+			long levels;
+			try { levels = std::stol(optarg); }
+			catch (std::logic_error&) { levels = 0; }
+			if (levels < 1 || levels > long(MAX_SPLIT_DEPTH))
+			{
+				std::cerr << "Error: Valid split depth (1-" << MAX_SPLIT_DEPTH << ") must be specified" << std::endl;
+				return EXIT_FAILURE;
+			}
+			splitDepth = size_t(levels);
+			break;
+		}
+		case 'f':
+			pdContainer = optarg; break;
+		case 'r':
+			modThree = true; break;
+		case 'H':
+			hugePages = true; break;
+		case 'N':
+			replicate = true; break;
+		case 's':
+			symmetryReduced = true; break;
+		case 'u':
+			dual = true; break;
+		case 'k':
+			keyed = true; break;
+		case 'e':
+			edgePatterns.emplace_back();
+			if (!parseEdgePatternDatabase(optarg, edgePatterns.back()))
+			{
+				std::cerr << "Error: Edge pattern must list 1-8 distinct edge pieces (0-11), separated by commas" << std::endl;
+				return EXIT_FAILURE;
+			}
+			break;
 		default:
 			std::cerr << "Error: Illegal option" << std::endl; return EXIT_FAILURE; break;
 		}
@@ -131,15 +348,110 @@ int main(int argc, char **argv)
 	if (!success)
 		return EXIT_FAILURE;
 
+	if (edgePatterns.size() > MAX_EDGE_PATTERN_DATABASES)
+	{
+		std::cerr << "Error: At most " << MAX_EDGE_PATTERN_DATABASES << " edge patterns may be given" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (modThree && !edgePatterns.empty())
+	{
+		std::cerr << "Error: Pattern databases modulo 3 are only available for the default edge sets" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (modThree && (hugePages || replicate))
+	{
+		std::cerr << "Error: Pattern databases modulo 3 cannot be placed on huge pages or NUMA nodes" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	//Only IDA* tracks the values along its path; other searches would recover each from scratch
+	if (modThree && (!needHeur || heuristicSearch == A_STAR || heuristicSearch == PURE_HEURISTIC))
+	{
+		std::cerr << "Error: Pattern databases modulo 3 are only available with IDA* (default and -c)" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (modThree && !pdContainer.empty())
+	{
+		std::cerr << "Error: Pattern databases modulo 3 are mapped from their own files, not a container file" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (symmetryReduced && (modThree || !pdContainer.empty()))
+	{
+		std::cerr << "Error: Symmetry-reduced pattern databases are not available modulo 3 or from a container file" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (dual && modThree)
+	{
+		std::cerr << "Error: Inverse lookups are not available in pattern databases modulo 3" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const SearchSettings settings{ threads, splitDepth, keyed };
+
+	//Pattern databases to use: the corners, then either the default or the given edge sets
+	std::vector<PatternDatabaseSpec> databaseSpecs = PATTERN_DATABASES;
+	if (!edgePatterns.empty())
+	{
+		databaseSpecs.resize(1);
+		databaseSpecs.insert(databaseSpecs.end(), edgePatterns.begin(), edgePatterns.end());
+	}
+
+	/* Symmetry-reduced databases have files of their own, of the reduced
+		sizes. An edge set that a symmetry carries onto an earlier one (as
+		the default set's complement, or any of the U and D, R and L, and
+		F and B layer edges onto another) shares that one's database, read
+		through the symmetry; only the databases themselves are kept in
+		databaseSpecs, each lookup naming its database and symmetry. */
+	std::vector<SymmetryReduction> reductions;
+	std::vector<std::pair<size_t, const Symmetry*>> reducedLookups;
+	if (symmetryReduced)
+	{
+		std::vector<PatternDatabaseSpec> sets = databaseSpecs;
+		databaseSpecs.clear();
+
+		//The default edge set stands for its complement too
+		if (edgePatterns.empty())
+		{
+			PatternDatabaseSpec complement;
+			for (uint8_t e = 0; e < Cube::NUMBER_OF_EDGES; e++)
+				if (std::count(EDGE_SET.begin(), EDGE_SET.end(), e) == 0)
+					complement.edges.push_back(e);
+			sets.push_back(complement);
+		}
+
+		for (const PatternDatabaseSpec &spec : sets)
+		{
+			const Symmetry *view = nullptr;
+			size_t shared = 0;
+			for (; !spec.edges.empty() && shared < databaseSpecs.size(); shared++)
+				if ((view = Symmetry::carrying(spec.edges, databaseSpecs[shared].edges)))
+					break;
+
+			if (view)
+			{
+				reducedLookups.push_back({ shared, (view == &Symmetry::all().front()) ? nullptr : view });
+				continue;
+			}
+
+			reductions.push_back(spec.edges.empty() ? SymmetryReduction() : SymmetryReduction(spec.edges));
+			databaseSpecs.push_back({ "sym" + spec.file, spec.description, reductions.back().size(), spec.edges });
+			reducedLookups.push_back({ databaseSpecs.size() - 1, nullptr });
+		}
+	}
+
 	//Validate algorithm settings, if needed
-	ManhattanMap m;
-	PatternDatabase corner, edge1, edge2;
+	ManhattanTable m;
+	PatternDatabase corner;
+	std::vector<EdgePatternDatabase> edges;
+	std::vector<ReducedPatternDatabase> reduced;
+	ModThreePatternDatabase cornerModThree, edgeModThree;
 	if (needAlg)
 	{
-		//Default to IDA*
-		if (!executeSearch)
-			executeSearch = [&hFunc](const CubeNode &a, const CubeNode &b) { return Search::IDAstar(a, b, hFunc); };
-
 		//Manual use of depth-first search not supported
 		if (!opts[TIME] && algName == "DEPTH-FIRST SEARCH")
 		{
@@ -152,77 +464,139 @@ int main(int argc, char **argv)
 		{
 			if (opts[MANHATTAN_USE])
 			{
-				std::cout << "Loading Manhattan distance table..." << std::endl;
-
+				//Load the table file if present, otherwise generate the distances here
 				std::ifstream mFile("manhattantable.txt");
-				if (!mFile)
+				if (mFile)
 				{
-					std::cerr << "Error: manhattantable.txt missing" << std::endl;
-					return EXIT_FAILURE;
+					std::cout << "Loading Manhattan distance table..." << std::endl;
+					m = loadManhattanTable(mFile);
+					mFile.close();
 				}
+				else
+					std::cout << "Generating Manhattan distance table..." << std::endl;
 
-				m = loadManhattanTable(mFile);
-				mFile.close();
+				//Greater of the edge and corner piece distance sums, divided by 4
+				bindSearch(heuristicSearch, ManhattanHeuristic{ m }, dual, settings, executeSearch, serialSearch);
+			}
+			//Or pattern databases modulo 3, mapped from their own files without the 4-bit ones ever being held
+			else if (modThree)
+			{
+				std::cout << "Loading pattern databases..." << std::endl;
 
-				//Total Manhattan distance is sum of edge piece distances, divided by 4
-				hFunc = [&m](const CubeNode &a, const CubeNode &b)
+				clock::time_point loadStart = clock::now();
+
+				try
 				{
-					size_t sum = 0;
-					for (size_t i = 0; i < 12; i++)
-						sum += lookupManhattanTable(a.cube.cubies[i], b.cube.cubies[i], m);
-					return sum / 4.0;
-				};
+					cornerModThree = ModThreePatternDatabase::map(MOD_THREE_FILES[0], PATTERN_DATABASES[0].n);
+					edgeModThree = ModThreePatternDatabase::map(MOD_THREE_FILES[1], PATTERN_DATABASES[1].n);
+				}
+				catch (std::ios_base::failure&) {
+					std::cerr << "Error: " << MOD_THREE_FILES[0] << " and " << MOD_THREE_FILES[1]
+						<< " must be generated (with -P)" << std::endl;
+					return EXIT_FAILURE;
+				}
+
+				//Total heuristic is max of three values, tracked along the search path
+				bindSearch(heuristicSearch, ModThreePatternDatabaseHeuristic{ cornerModThree, edgeModThree },
+					settings, executeSearch, serialSearch);
+
+				std::cout << "Loaded in " << std::chrono::duration<double>(clock::now() - loadStart).count()
+					<< " seconds" << std::endl;
 			}
 			//Otherwise, default to pattern databases
 			else
 			{
 				std::cout << "Loading pattern databases..." << std::endl;
 
-				//Load corner database
-				std::ifstream pdFile("cornerpd.bin", std::ifstream::binary);
-				if (!pdFile)
-				{
-					std::cerr << "Error: cornerpd.bin missing" << std::endl;
-					return EXIT_FAILURE;
-				}				
+				clock::time_point loadStart = clock::now();
 
-				corner = loadPatternDatabase(pdFile, 88179840);
-				pdFile.close();
+				//Corner database first, then each edge database
+				std::vector<PatternDatabase*> databases { &corner };
+				for (size_t i = 1; i < databaseSpecs.size(); i++)
+					edges.push_back({ databaseSpecs[i].edges, PatternDatabase() });
+				for (EdgePatternDatabase &e : edges)
+					databases.push_back(&e.pd);
 
-				//Load edge 1 database
-				pdFile.open("edge1pd.bin", std::ifstream::binary);
-				if (!pdFile)
+				//Decode all databases from the container file, if given
+				if (!pdContainer.empty())
 				{
-					std::cerr << "Error: edge1pd.bin missing" << std::endl;
-					return EXIT_FAILURE;
+					std::ifstream pdFile(pdContainer, std::ifstream::binary);
+					if (!pdFile)
+					{
+						std::cerr << "Error: " << pdContainer << " missing" << std::endl;
+						return EXIT_FAILURE;
+					}
+
+					std::vector<PatternDatabaseFile::Table> tables;
+					try { tables = PatternDatabaseFile::read(pdFile, threads); }
+					catch (std::ios_base::failure &e) {
+						std::cerr << "Error: " << e.what() << std::endl;
+						return EXIT_FAILURE;
+					}
+
+					for (size_t i = 0; i < databaseSpecs.size(); i++)
+					{
+						const PatternDatabaseSpec &spec = databaseSpecs[i];
+						auto t = std::find_if(tables.begin(), tables.end(), [&spec](const PatternDatabaseFile::Table &t) {
+							return t.description == spec.description && t.n == spec.n
+								&& t.ranking == PatternDatabaseFile::LEHMER_ORIENTATION;
+						});
+
+						if (t == tables.end())
+						{
+							std::cerr << "Error: " << spec.description << " missing from " << pdContainer << std::endl;
+							return EXIT_FAILURE;
+						}
+
+						*databases[i] = std::move(t->pd);
+					}
 				}
-
-				edge1 = loadPatternDatabase(pdFile, 42577920);
-				pdFile.close();
-
-				//Load edge 2 database
-				pdFile.open("edge2pd.bin", std::ifstream::binary);
-				if (!pdFile)
+				//Otherwise, map each database file, so that concurrent solvers share one copy
+				else
 				{
-					std::cerr << "Error: edge2pd.bin missing" << std::endl;
-					return EXIT_FAILURE;
+					for (size_t i = 0; i < databaseSpecs.size(); i++)
+					{
+						try { *databases[i] = PatternDatabase::map(databaseSpecs[i].file, databaseSpecs[i].n); }
+						catch (std::ios_base::failure&) {
+							std::cerr << "Error: " << databaseSpecs[i].file << " missing" << std::endl;
+							return EXIT_FAILURE;
+						}
+					}
 				}
 
-				edge2 = loadPatternDatabase(pdFile, 42577920);
-				pdFile.close();
+				//Copy each database onto huge pages and/or every NUMA node, if asked
+				if (hugePages || replicate)
+				{
+					try
+					{
+						for (PatternDatabase *pd : databases)
+							*pd = pd->place(hugePages, replicate);
+					}
+					catch (std::bad_alloc&) {
+						std::cerr << "Error: Unable to allocate pattern database memory" << std::endl;
+						return EXIT_FAILURE;
+					}
+
+					std::cout << "Pattern databases held in " << corner.placement() << std::endl;
+				}
 
-				//Total heuristic is max of three pattern database lookups
-				hFunc = [&corner, &edge1, &edge2](const CubeNode &a, const CubeNode &b)
+				//The max over the symmetry-reduced database lookups, some sharing a database
+				if (symmetryReduced)
 				{
-					size_t i = getCornerConfigIndex(enumerateCornerConfig(a.cube));
-					double c = (i % 2 == 0) ? corner[i / 2].a() : corner[i / 2].b();
-					i = getEdgeConfigIndex(enumerateEdgeConfig(a.cube, 1));
-					double e1 = (i % 2 == 0) ? edge1[i / 2].a() : edge1[i / 2].b();
-					i = getEdgeConfigIndex(enumerateEdgeConfig(a.cube, 2));
-					double e2 = (i % 2 == 0) ? edge2[i / 2].a() : edge2[i / 2].b();
-
-					return std::max({ c, e1, e2 });
-				};
+					for (const std::pair<size_t, const Symmetry*> &l : reducedLookups)
+						reduced.push_back({ reductions[l.first], *databases[l.first], l.second });
+
+					bindSearch(heuristicSearch, ReducedPatternDatabasesHeuristic{ reduced }, dual, settings, executeSearch, serialSearch);
+				}
+				//Total heuristic is max of three pattern database lookups, two in the edge database
+				else if (edgePatterns.empty())
+					bindSearch(heuristicSearch, PatternDatabaseHeuristic{ corner, edges[0].pd }, dual, settings, executeSearch, serialSearch);
+				//Or the max over the corner and all given edge databases
+				else
+					bindSearch(heuristicSearch, EdgePatternDatabasesHeuristic{ corner, edges }, dual, settings, executeSearch, serialSearch);
+
+				std::cout << "Loaded in " << std::chrono::duration<double>(clock::now() - loadStart).count()
+					<< " seconds" << std::endl;
 			}
 		}
 	}
@@ -268,6 +642,34 @@ int main(int argc, char **argv)
 	}
 
 
+	/* MICROBENCHMARKS */
+	if (opts[BENCHMARK])
+	{
+		std::cout << "Benchmarking pattern database index ranking..." << std::endl;
+		benchmarkRanking(std::cout);
+
+		std::cout << std::endl << "Benchmarking piece configuration enumeration..." << std::endl;
+		benchmarkEnumeration(std::cout);
+
+		std::cout << std::endl << "Benchmarking Manhattan distance summation..." << std::endl;
+		benchmarkManhattan(std::cout);
+
+		std::cout << std::endl << "Benchmarking batched pattern database lookups..." << std::endl;
+		benchmarkPrefetch(std::cout);
+
+		std::cout << std::endl << "Benchmarking symmetry-reduced pattern databases..." << std::endl;
+		benchmarkSymmetryReduction(std::cout);
+
+		std::cout << std::endl << "Benchmarking inverse state lookups..." << std::endl;
+		benchmarkDualHeuristic(std::cout);
+
+		std::cout << std::endl << "Benchmarking pattern database lookup latency..." << std::endl;
+		benchmarkLookupLatency(std::cout);
+
+		return EXIT_SUCCESS;
+	}
+
+
 	/* PATTERN DATABASE GENERATION */
 	if (opts[PATTERN])
 	{
@@ -275,18 +677,59 @@ int main(int argc, char **argv)
 
 		std::ofstream file;
 
-		file.open("cornerpd.bin", std::ofstream::binary);
-		generateCornerPatternDatabase(file);
+		//Symmetry-reduced databases: those of the corners and the default edge set, or only of the given edge
+		//sets, each once however many sets share it
+		if (symmetryReduced)
+		{
+			for (size_t i = edgePatterns.empty() ? 0 : 1; i < databaseSpecs.size(); i++)
+			{
+				file.open(databaseSpecs[i].file, std::ofstream::binary);
+				generateReducedPatternDatabase(file, reductions[i], threads);
+				file.close();
+			}
+
+			return EXIT_SUCCESS;
+		}
+
+		//Only generate the given edge databases, if any
+		if (!edgePatterns.empty())
+		{
+			for (const PatternDatabaseSpec &spec : edgePatterns)
+			{
+				file.open(spec.file, std::ofstream::binary);
+				generateEdgePatternDatabase(file, spec.edges, threads);
+				file.close();
+			}
+
+			return EXIT_SUCCESS;
+		}
+
+		file.open(PATTERN_DATABASES[0].file, std::ofstream::binary);
+		generateCornerPatternDatabase(file, threads);
 		file.close();
 
-		file.open("edge1pd.bin", std::ofstream::binary);
-		generateEdgePatternDatabase(file, 1);
+		file.open(PATTERN_DATABASES[1].file, std::ofstream::binary);
+		generateEdgePatternDatabase(file, PATTERN_DATABASES[1].edges, threads);
 		file.close();
 
-		file.open("edge2pd.bin", std::ofstream::binary);
-		generateEdgePatternDatabase(file, 2);
+		//Also bundle them into one compressed container file, for distribution
+		std::vector<PatternDatabaseFile::Table> tables;
+		for (const PatternDatabaseSpec &spec : PATTERN_DATABASES)
+			tables.push_back({ spec.description, PatternDatabaseFile::LEHMER_ORIENTATION, spec.n,
+				PatternDatabase::map(spec.file, spec.n) });
+
+		file.open(PATTERN_DATABASE_CONTAINER, std::ofstream::binary);
+		PatternDatabaseFile::write(file, tables, true, threads);
 		file.close();
 
+		//And reduce them modulo 3, for -r to map in half the memory
+		for (size_t i = 0; i < tables.size(); i++)
+		{
+			file.open(MOD_THREE_FILES[i], std::ofstream::binary);
+			ModThreePatternDatabase(tables[i].pd, tables[i].n).write(file);
+			file.close();
+		}
+
 		return EXIT_SUCCESS;
 	}
 
@@ -298,6 +741,7 @@ int main(int argc, char **argv)
 	/* TEST CASE TIMING */
 	if (opts[TIME])
 	{
+		std::cout << "Move kernel: " << Cube::applyKernelName() << std::endl << std::endl;
 		std::cout << "Time in seconds to solve depth n [median]:" << std::endl;
 
 		for (depth = 2; depth <= 20; depth++)
@@ -322,6 +766,7 @@ int main(int argc, char **argv)
 
 			//Solve and time all test cubes
 			std::vector<std::chrono::duration<double>> times;
+			std::vector<double> speedUps;
 			for (auto &t : testCases)
 			{
 				Cube c(t);
@@ -331,9 +776,21 @@ int main(int argc, char **argv)
 				auto t1 = clock::now();
 				times.emplace_back(t1 - t0);
 				std::cout << times.back().count() << " ";
+
+				//Compare against the single-threaded engine, if parallel
+				if (serialSearch)
+				{
+					t0 = clock::now();
+					serialSearch(cn, GOAL_CUBE_NODE);
+					t1 = clock::now();
+					speedUps.push_back(std::chrono::duration<double>(t1 - t0) / times.back());
+				}
 			}
 
-			std::cout << "[" << median(times).count() << "]" << std::endl;
+			std::cout << "[" << median(times).count() << "]";
+			if (serialSearch)
+				std::cout << " speed-up on " << threads << " threads: " << median(speedUps) << "x";
+			std::cout << std::endl;
 		}
 
 		return EXIT_SUCCESS;
@@ -367,8 +824,8 @@ int main(int argc, char **argv)
 	std::cout << "Path: ";
 	if (path.empty())
 		std::cout << "NOT FOUND";
-	else for (auto &p : path)
-		std::cout << p << " ";
+	else for (Search::Operation p : path)
+		std::cout << Cube::MOVE_NAMES[p] << " ";
 
 	std::cout << std::endl << "Depth: " << path.size() << std::endl;
 	std::cout << "Time taken: " << std::chrono::duration<double>(t1 - t0).count() << " seconds" << std::endl;